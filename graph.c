@@ -0,0 +1,243 @@
+/*
+ * This file is part of the uumpy project
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Nicko van Someren
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// SPDX-License-Identifier: MIT
+
+#include <string.h>
+
+#include "py/runtime.h"
+
+#include "moduumpy.h"
+#include "ufunc.h"
+#include "graph.h"
+
+#if UUMPY_ENABLE_GRAPH
+
+// A graph records the element-wise operations carried out by a function
+// and can then replay them without running the function again. This saves
+// the argument parsing, the spec lookup, the broadcasting and the result
+// allocation that each operation would otherwise pay for every time. A run
+// still allocates when a step's operands overlap, since resolving that
+// copies one of them.
+//
+// The graph is traced by calling the function with example input arrays.
+// Every arithmetic operator, unary operator, math function and slice
+// assignment is recorded, along with the arrays it reads and writes. Any
+// intermediate arrays are kept and are overwritten on each run, as is the
+// result that the function returned. Any other operation raises while
+// tracing, as it could not be replayed. Control flow that depends on the
+// shapes of the arrays is only evaluated while tracing.
+
+// Each step keeps its own copies of the array headers since the ones used
+// when tracing are often views that only lived on the stack
+typedef struct _uumpy_graph_step {
+    size_t op_count;
+    bool is_copy;
+    uumpy_universal_spec spec;
+    uumpy_obj_ndarray_t ops[3];
+} uumpy_graph_step;
+
+typedef struct _uumpy_obj_graph_t {
+    mp_obj_base_t base;
+    size_t input_count;
+    mp_obj_t *inputs;
+    mp_obj_t result;
+    size_t step_count;
+    size_t step_alloc;
+    uumpy_graph_step *steps;
+} uumpy_obj_graph_t;
+
+uumpy_obj_graph_t *uumpy_graph_recording = NULL;
+
+void uumpy_graph_unrecordable(void) {
+    mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("operation can not be recorded"));
+}
+
+void uumpy_graph_record(size_t op_count, uumpy_obj_ndarray_t **ops,
+                        const uumpy_universal_spec *spec) {
+    uumpy_obj_graph_t *g = uumpy_graph_recording;
+
+    if (g->step_count == g->step_alloc) {
+        size_t new_alloc = g->step_alloc ? 2 * g->step_alloc : 8;
+        g->steps = uumpy_renew(uumpy_graph_step, g->steps, g->step_alloc, new_alloc);
+        g->step_alloc = new_alloc;
+    }
+
+    uumpy_graph_step *step = &g->steps[g->step_count];
+
+    step->op_count = op_count;
+    step->is_copy = (spec == NULL);
+    if (spec) {
+        step->spec = *spec;
+    }
+    for (size_t k=0; k < op_count; k++) {
+        step->ops[k] = *ops[k];
+        step->ops[k].dim_info = uumpy_new(uumpy_dim_info, ops[k]->dim_count);
+        memcpy(step->ops[k].dim_info, ops[k]->dim_info, ops[k]->dim_count * sizeof(uumpy_dim_info));
+    }
+
+    g->step_count++;
+}
+
+static bool uumpy_graph_is_result(mp_obj_t result) {
+    if (mp_obj_is_type(result, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+        return true;
+    }
+
+    mp_int_t count;
+    mp_obj_t *items;
+
+    if (!mp_obj_is_type(result, &mp_type_tuple) || !uumpy_util_get_list_tuple(result, &count, &items)) {
+        return false;
+    }
+
+    for (mp_int_t i=0; i < count; i++) {
+        if (!mp_obj_is_type(items[i], MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static mp_obj_t uumpy_graph_make_new(const mp_obj_type_t *type_in, size_t n_args,
+                                     size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, MP_OBJ_FUN_ARGS_MAX, false);
+
+    if (uumpy_graph_recording) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("graphs can not be nested"));
+    }
+
+    uumpy_obj_graph_t *o = uumpy_new_obj(uumpy_obj_graph_t);
+    o->base.type = type_in;
+    o->input_count = n_args - 1;
+    o->inputs = uumpy_new(mp_obj_t, o->input_count);
+    o->result = mp_const_none;
+    o->step_count = 0;
+    o->step_alloc = 0;
+    o->steps = NULL;
+
+    for (size_t i=0; i < o->input_count; i++) {
+        if (!mp_obj_is_type(args[i + 1], MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+            mp_raise_TypeError(MP_ERROR_TEXT("graph inputs must be arrays"));
+        }
+        o->inputs[i] = args[i + 1];
+    }
+
+    // Trace the function, making sure that recording stops if it raises
+    nlr_buf_t nlr;
+    uumpy_graph_recording = o;
+
+    if (nlr_push(&nlr) == 0) {
+        o->result = mp_call_function_n_kw(args[0], o->input_count, 0, args + 1);
+        nlr_pop();
+        uumpy_graph_recording = NULL;
+    } else {
+        uumpy_graph_recording = NULL;
+        nlr_jump(nlr.ret_val);
+    }
+
+    // Scalars can't be updated in place
+    if (!uumpy_graph_is_result(o->result)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("graph must return an array or a tuple of arrays"));
+    }
+
+    return MP_OBJ_FROM_PTR(o);
+}
+
+// Run the graph. The inputs are copied into the arrays that the graph was
+// traced with, unless they are the very same arrays.
+static mp_obj_t uumpy_graph_run(size_t n_args, const mp_obj_t *args) {
+    uumpy_obj_graph_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    if (n_args - 1 != self->input_count) {
+        mp_raise_TypeError(MP_ERROR_TEXT("wrong number of graph inputs"));
+    }
+
+    for (size_t i=0; i < self->input_count; i++) {
+        if (args[i + 1] == self->inputs[i]) {
+            continue;
+        }
+        if (!mp_obj_is_type(args[i + 1], MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+            mp_raise_TypeError(MP_ERROR_TEXT("graph inputs must be arrays"));
+        }
+
+        uumpy_obj_ndarray_t *ops[2] = {MP_OBJ_TO_PTR(self->inputs[i]), MP_OBJ_TO_PTR(args[i + 1])};
+        uumpy_iteration_views overlap_views;
+        uumpy_universal_spec copy_spec;
+
+        if (!ndarray_compare_dimensions(ops[0], ops[1])) {
+            mp_raise_ValueError(MP_ERROR_TEXT("graph input has the wrong shape"));
+        }
+
+        ufunc_resolve_overlap(2, ops, &overlap_views);
+        ufunc_find_copy_spec(ops[1], ops[0], NULL, &copy_spec);
+        ufunc_apply_unary(ops[0], ops[1], &copy_spec);
+    }
+
+    for (size_t s=0; s < self->step_count; s++) {
+        uumpy_graph_step *step = &self->steps[s];
+        uumpy_obj_ndarray_t *ops[3] = {&step->ops[0], &step->ops[1], &step->ops[2]};
+        uumpy_iteration_views overlap_views;
+        bool ok;
+
+        ufunc_resolve_overlap(step->op_count, ops, &overlap_views);
+
+        if (step->is_copy) {
+            ufunc_find_copy_spec(ops[1], ops[0], NULL, &step->spec);
+        }
+
+        if (step->op_count == 2) {
+            ok = ufunc_apply_unary(ops[0], ops[1], &step->spec);
+        } else {
+            ok = ufunc_apply_binary(ops[0], ops[1], ops[2], &step->spec);
+        }
+
+        if (!ok) {
+            mp_raise_ValueError(MP_ERROR_TEXT("math error"));
+        }
+    }
+
+    return self->result;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR(uumpy_graph_run_obj, 1, uumpy_graph_run);
+
+static const mp_rom_map_elem_t uumpy_graph_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_run), MP_ROM_PTR(&uumpy_graph_run_obj) },
+};
+static MP_DEFINE_CONST_DICT(uumpy_graph_locals_dict, uumpy_graph_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    uumpy_type_Graph,
+    MP_QSTR_Graph,
+    MP_TYPE_FLAG_NONE,
+    make_new, uumpy_graph_make_new,
+    locals_dict, &uumpy_graph_locals_dict
+);
+
+#endif // UUMPY_ENABLE_GRAPH
@@ -0,0 +1,71 @@
+/*
+ * This file is part of the uumpy project
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Nicko van Someren
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// SPDX-License-Identifier: MIT
+
+#ifndef UUMPY_INCLUDED_GRAPH_H
+#define UUMPY_INCLUDED_GRAPH_H
+
+#if UUMPY_ENABLE_GRAPH
+
+struct _uumpy_obj_graph_t;
+
+extern const mp_obj_type_t uumpy_type_Graph;
+
+// Set while a graph is being traced
+extern struct _uumpy_obj_graph_t *uumpy_graph_recording;
+
+void uumpy_graph_record(size_t op_count, uumpy_obj_ndarray_t **ops,
+                        const uumpy_universal_spec *spec);
+
+// Element-wise operations call this just before applying their spec. Copies
+// pass a NULL spec since their spec depends on the direction of iteration.
+#define UUMPY_GRAPH_RECORD(op_count, ops, spec) \
+    do { \
+        if (uumpy_graph_recording) { \
+            uumpy_graph_record((op_count), (ops), (spec)); \
+        } \
+    } while (0)
+
+NORETURN void uumpy_graph_unrecordable(void);
+
+// Every other operation calls this first. While tracing it would only run
+// once, so its result would be frozen into the graph.
+#define UUMPY_GRAPH_UNRECORDABLE() \
+    do { \
+        if (uumpy_graph_recording) { \
+            uumpy_graph_unrecordable(); \
+        } \
+    } while (0)
+
+#else
+
+#define UUMPY_GRAPH_RECORD(op_count, ops, spec) do { } while (0)
+#define UUMPY_GRAPH_UNRECORDABLE() do { } while (0)
+
+#endif // UUMPY_ENABLE_GRAPH
+
+#endif // UUMPY_INCLUDED_GRAPH_H
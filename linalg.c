@@ -27,6 +27,7 @@
 // SPDX-License-Identifier: MIT
 
 #include <assert.h>
+#include <float.h>
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
@@ -40,9 +41,12 @@
 #include "moduumpy.h"
 #include "linalg.h"
 #include "ufunc.h"
+#include "graph.h"
+#include "uusparse.h"
 
 #define ABS(x) MICROPY_FLOAT_C_FUN(fabs)(x)
 #define FREXP(x, exp_p) MICROPY_FLOAT_C_FUN(frexp)(x, exp_p)
+#define SQRT(x) MICROPY_FLOAT_C_FUN(sqrt)(x)
 
 #if UUMPY_ENABLE_LINALG
 
@@ -75,13 +79,17 @@ static void _swap_negate_rows(mp_float_t *data,
     }
 }
 
-// Subtract a multiple of row a from row b so that the row b starts with a zero
+// Subtract a multiple of row a from row b so that the row b starts with a zero.
+// Division is much slower than multiplication on many of our targets, so
+// the caller passes the reciprocal of the leading entry of row a, which is
+// computed once per pivot rather than once per row.
 static void _subtract_to_zero(mp_float_t *data,
                               size_t width, size_t start,
-                              size_t a_row_index, size_t b_row_index) {
+                              size_t a_row_index, size_t b_row_index,
+                              mp_float_t inv_pivot) {
     mp_float_t *row_a = data + (a_row_index * width);
     mp_float_t *row_b = data + (b_row_index * width);
-    mp_float_t multiple = row_b[start] / row_a[start];
+    mp_float_t multiple = row_b[start] * inv_pivot;
     
     if (multiple != 0) {
         row_b[start] = 0.0;
@@ -91,11 +99,14 @@ static void _subtract_to_zero(mp_float_t *data,
     }    
 }
 
-static void _divide_row(mp_float_t *data, size_t width,
-                        size_t start, size_t row_index, mp_float_t d) {
+// Scale a row so that it starts with a one, given the reciprocal of its
+// leading entry
+static void _normalise_row(mp_float_t *data, size_t width,
+                           size_t start, size_t row_index, mp_float_t inv_d) {
     mp_float_t *row = data + (row_index * width);
-    for (size_t i = start; i < width; i++) {
-        row[i] /= d;
+    row[start] = 1.0;
+    for (size_t i = start+1; i < width; i++) {
+        row[i] *= inv_d;
     }
 }
 
@@ -140,22 +151,25 @@ static size_t _uumpy_linalg_reduce_array(uumpy_obj_ndarray_t *a, bool diag,
             if (best_row != y) {
                 _swap_negate_rows(data, width, x, y, best_row, true);
             }
+            mp_float_t inv_pivot = 1 / data[x + y * width];
+            // Normalising first leaves a pivot of one, so that the other
+            // rows need no scaling at all
+            if (norm) {
+                _normalise_row(data, width, x, y, inv_pivot);
+                det_change *= inv_pivot;
+                inv_pivot = 1.0;
+            }
             if (diag) {
                 for (mp_int_t j = 0; j < height; j++) {
                     if (j != y) {
-                        _subtract_to_zero(data, width, x, y, j);
+                        _subtract_to_zero(data, width, x, y, j, inv_pivot);
                     }
                 }
             } else {
                 for (mp_int_t j = y+1; j < height; j++) {
-                    _subtract_to_zero(data, width, x, y, j);
+                    _subtract_to_zero(data, width, x, y, j, inv_pivot);
                 }
             }
-            if (norm) {
-                mp_float_t d = data[x + y * width];
-                _divide_row(data, width, x, y, d);
-                det_change /= d;
-            }
             y += 1;
         }
         x += 1;
@@ -169,6 +183,8 @@ static size_t _uumpy_linalg_reduce_array(uumpy_obj_ndarray_t *a, bool diag,
 }
 
 static mp_obj_t uumpy_linalg_re(mp_obj_t arg_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
     uumpy_obj_ndarray_t *o = uumpy_array_from_value(arg_in, UUMPY_DEFAULT_TYPE);
     
     // FIXME
@@ -183,6 +199,8 @@ static mp_obj_t uumpy_linalg_re(mp_obj_t arg_in) {
 static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_linalg_re_obj, uumpy_linalg_re);
 
 static mp_obj_t uumpy_linalg_det(mp_obj_t arg_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
     uumpy_obj_ndarray_t *o = uumpy_array_from_value(arg_in, UUMPY_DEFAULT_TYPE);
     
     // FIXME
@@ -196,11 +214,13 @@ static mp_obj_t uumpy_linalg_det(mp_obj_t arg_in) {
     mp_float_t det_change;
     _uumpy_linalg_reduce_array(o, false, true, &det_change);
     
-    return  mp_obj_new_float(1 / det_change);
+    return UUMPY_BOXED_RESULT(mp_obj_new_float(1 / det_change));
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_linalg_det_obj, uumpy_linalg_det);
 
 static mp_obj_t uumpy_linalg_inv(mp_obj_t arg_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
     uumpy_obj_ndarray_t *o = uumpy_array_from_value(arg_in, UUMPY_DEFAULT_TYPE);
 
     // FIXME
@@ -248,20 +268,24 @@ static mp_obj_t uumpy_linalg_inv(mp_obj_t arg_in) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_linalg_inv_obj, uumpy_linalg_inv);
 
-static mp_obj_t uumpy_linalg_solve(mp_obj_t a_in, mp_obj_t b_in) {
-    uumpy_obj_ndarray_t *a = uumpy_array_from_value(a_in, UUMPY_DEFAULT_TYPE);
-    uumpy_obj_ndarray_t *b = uumpy_array_from_value(b_in, UUMPY_DEFAULT_TYPE);
-
+static void _linalg_solve_check_args(uumpy_obj_ndarray_t *a, uumpy_obj_ndarray_t *b) {
     // FIXME
     if (a->dim_count != 2 || b->dim_count != 1) {
         mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("can only solve single set of equations"));
     }
     if (a->dim_info[0].length != a->dim_info[1].length) {
-        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("equationa matrix must be square"));
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("equation matrix must be square"));
     }
     if (a->dim_info[0].length != b->dim_info[0].length) {
-        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("dimensions dton't match"));
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("dimensions don't match"));
     }
+}
+
+static mp_obj_t _linalg_solve_direct(mp_obj_t a_in, mp_obj_t b_in) {
+    uumpy_obj_ndarray_t *a = uumpy_array_from_value(a_in, UUMPY_DEFAULT_TYPE);
+    uumpy_obj_ndarray_t *b = uumpy_array_from_value(b_in, UUMPY_DEFAULT_TYPE);
+
+    _linalg_solve_check_args(a, b);
 
     mp_int_t length = a->dim_info[0].length;
     mp_int_t temp_dims[2];
@@ -297,14 +321,1316 @@ static mp_obj_t uumpy_linalg_solve(mp_obj_t a_in, mp_obj_t b_in) {
     
     return MP_OBJ_FROM_PTR(b);
 }
-static MP_DEFINE_CONST_FUN_OBJ_2(uumpy_linalg_solve_obj, uumpy_linalg_solve);
+// LU factorisation with partial pivoting, in place in a contiguous n x n
+// matrix, with the row swaps recorded in pivot. The same code is used
+// in the default float type and in single precision, which is what the
+// factors are kept in when solutions are refined. Factoring returns false
+// if the matrix is exactly singular.
+#define UUMPY_LINALG_LU_FUNCTIONS(name, type)                                    \
+static bool _linalg_lu_factor_##name(mp_int_t n, type *lu, mp_int_t *pivot) {   \
+    for (mp_int_t k=0; k < n; k++) {                                             \
+        mp_int_t p = k;                                                          \
+        for (mp_int_t i=k + 1; i < n; i++) {                                     \
+            if (ABS(lu[i * n + k]) > ABS(lu[p * n + k])) {                       \
+                p = i;                                                           \
+            }                                                                    \
+        }                                                                        \
+        pivot[k] = p;                                                            \
+        if (lu[p * n + k] == 0) {                                                \
+            return false;                                                        \
+        }                                                                        \
+        if (p != k) {                                                            \
+            for (mp_int_t j=0; j < n; j++) {                                     \
+                type t = lu[k * n + j];                                          \
+                lu[k * n + j] = lu[p * n + j];                                   \
+                lu[p * n + j] = t;                                               \
+            }                                                                    \
+        }                                                                        \
+        type inv_pivot = 1 / lu[k * n + k];                                      \
+        for (mp_int_t i=k + 1; i < n; i++) {                                     \
+            type l = lu[i * n + k] * inv_pivot;                                  \
+            lu[i * n + k] = l;                                                   \
+            for (mp_int_t j=k + 1; j < n; j++) {                                 \
+                lu[i * n + j] -= l * lu[k * n + j];                              \
+            }                                                                    \
+        }                                                                        \
+    }                                                                            \
+    return true;                                                                 \
+}                                                                                \
+                                                                                 \
+/* Solve A x = b, or A^T x = b, in place in x */                                 \
+static void _linalg_lu_solve_##name(mp_int_t n, const type *lu, const mp_int_t *pivot, \
+                                    type *x, bool transpose) {                   \
+    if (!transpose) {                                                            \
+        for (mp_int_t k=0; k < n; k++) {                                         \
+            type t = x[k];                                                       \
+            x[k] = x[pivot[k]];                                                  \
+            x[pivot[k]] = t;                                                     \
+        }                                                                        \
+        for (mp_int_t i=1; i < n; i++) {                                         \
+            for (mp_int_t j=0; j < i; j++) {                                     \
+                x[i] -= lu[i * n + j] * x[j];                                    \
+            }                                                                    \
+        }                                                                        \
+        for (mp_int_t i=n - 1; i >= 0; i--) {                                    \
+            for (mp_int_t j=i + 1; j < n; j++) {                                 \
+                x[i] -= lu[i * n + j] * x[j];                                    \
+            }                                                                    \
+            x[i] /= lu[i * n + i];                                               \
+        }                                                                        \
+    } else {                                                                     \
+        for (mp_int_t i=0; i < n; i++) {                                         \
+            for (mp_int_t j=0; j < i; j++) {                                     \
+                x[i] -= lu[j * n + i] * x[j];                                    \
+            }                                                                    \
+            x[i] /= lu[i * n + i];                                               \
+        }                                                                        \
+        for (mp_int_t i=n - 1; i >= 0; i--) {                                    \
+            for (mp_int_t j=i + 1; j < n; j++) {                                 \
+                x[i] -= lu[j * n + i] * x[j];                                    \
+            }                                                                    \
+        }                                                                        \
+        for (mp_int_t k=n - 1; k >= 0; k--) {                                    \
+            type t = x[k];                                                       \
+            x[k] = x[pivot[k]];                                                  \
+            x[pivot[k]] = t;                                                     \
+        }                                                                        \
+    }                                                                            \
+}
+
+UUMPY_LINALG_LU_FUNCTIONS(float, mp_float_t)
+#if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
+UUMPY_LINALG_LU_FUNCTIONS(single, float)
+#else
+#define _linalg_lu_factor_single _linalg_lu_factor_float
+#define _linalg_lu_solve_single _linalg_lu_solve_float
+#endif
+
+#define UUMPY_LINALG_REFINE_MAX_STEPS (10)
+
+// Solve with the factors in single precision, which is all that many
+// FPUs handle in hardware, then refine the solution using residuals
+// computed in double precision. While the matrix is not too badly
+// conditioned for single precision this converges to a solution about
+// as accurate as one factored in double precision. If the corrections
+// stop shrinking while they are still large then the matrix is too
+// ill-conditioned and we raise an error rather than return a poor answer.
+static mp_obj_t _linalg_solve_refined(mp_obj_t a_in, mp_obj_t b_in) {
+    uumpy_obj_ndarray_t *a = uumpy_array_from_value(a_in, UUMPY_DEFAULT_TYPE);
+    uumpy_obj_ndarray_t *b = uumpy_array_from_value(b_in, UUMPY_DEFAULT_TYPE);
+
+    _linalg_solve_check_args(a, b);
+
+    // Both arrays are fresh copies, so they are contiguous
+    mp_int_t n = a->dim_info[0].length;
+    mp_float_t *a_data = (mp_float_t *) a->data;
+    mp_float_t *b_data = (mp_float_t *) b->data;
+
+    float *lu = uumpy_new(float, n * n + n);
+    float *d = lu + n * n;
+    mp_int_t *pivot = uumpy_new(mp_int_t, n);
+    double *x = uumpy_new(double, n);
+
+    for (mp_int_t i=0; i < n * n; i++) {
+        lu[i] = a_data[i];
+    }
+    if (!_linalg_lu_factor_single(n, lu, pivot)) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("singular matrix"));
+    }
+
+    for (mp_int_t i=0; i < n; i++) {
+        d[i] = b_data[i];
+    }
+    _linalg_lu_solve_single(n, lu, pivot, d, false);
+    for (mp_int_t i=0; i < n; i++) {
+        x[i] = d[i];
+    }
+
+    double last_change = INFINITY;
+    for (mp_int_t step=0; step < UUMPY_LINALG_REFINE_MAX_STEPS; step++) {
+        for (mp_int_t i=0; i < n; i++) {
+            double r = b_data[i];
+            for (mp_int_t j=0; j < n; j++) {
+                r -= (double) a_data[i * n + j] * x[j];
+            }
+            d[i] = (float) r;
+        }
+        _linalg_lu_solve_single(n, lu, pivot, d, false);
+
+        double change = 0;
+        double size = 0;
+        for (mp_int_t i=0; i < n; i++) {
+            x[i] += d[i];
+            change = MAX(change, fabs((double) d[i]));
+            size = MAX(size, fabs(x[i]));
+        }
+
+        if (change <= 4 * DBL_EPSILON * size) {
+            break;
+        }
+        if (change > last_change / 2) {
+            // We are down to rounding noise, which is fine so long as it
+            // is well below what the single precision factors could give
+            if (change > FLT_EPSILON * size) {
+                mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("matrix is too ill-conditioned"));
+            }
+            break;
+        }
+        last_change = change;
+    }
+
+    for (mp_int_t i=0; i < n; i++) {
+        b_data[i] = x[i];
+    }
+
+    m_del(double, x, n);
+    m_del(mp_int_t, pivot, n);
+    m_del(float, lu, n * n + n);
+
+    return MP_OBJ_FROM_PTR(b);
+}
+
+static mp_obj_t uumpy_linalg_solve(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_a,
+        ARG_b,
+        ARG_refine,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_a,      MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_b,      MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_refine, MP_ARG_KW_ONLY  | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_refine].u_bool) {
+        return _linalg_solve_refined(args[ARG_a].u_obj, args[ARG_b].u_obj);
+    }
+    return _linalg_solve_direct(args[ARG_a].u_obj, args[ARG_b].u_obj);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_linalg_solve_obj, 2, uumpy_linalg_solve);
+
+#define UUMPY_LINALG_COND_MAX_STEPS (5)
+
+// Estimate the condition number in the 1-norm, ||A|| ||A^-1||, using
+// Hager's method as refined by Higham (the LAPACK xLACON estimator). This
+// needs a few solves with the LU factors and their transpose rather than
+// the inverse itself, so it costs little more than the factorisation.
+// An exactly singular matrix gives infinity.
+static mp_obj_t uumpy_linalg_cond(mp_obj_t a_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_obj_ndarray_t *a = uumpy_array_from_value(a_in, UUMPY_DEFAULT_TYPE);
+
+    if (a->dim_count != 2 || a->dim_info[0].length != a->dim_info[1].length) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("matrix must be square"));
+    }
+
+    mp_int_t n = a->dim_info[0].length;
+    mp_float_t *lu = (mp_float_t *) a->data;
+    mp_float_t a_norm = 0;
+
+    for (mp_int_t j=0; j < n; j++) {
+        mp_float_t sum = 0;
+        for (mp_int_t i=0; i < n; i++) {
+            sum += ABS(lu[i * n + j]);
+        }
+        a_norm = MAX(a_norm, sum);
+    }
+
+    mp_int_t *pivot = uumpy_new(mp_int_t, n);
+    if (n == 0 || !_linalg_lu_factor_float(n, lu, pivot)) {
+        m_del(mp_int_t, pivot, n);
+        return UUMPY_BOXED_RESULT(mp_obj_new_float(n ? INFINITY : 0));
+    }
+
+    // x is this step's input, y = A^-1 x and z = A^-T sign(y)
+    mp_float_t *x = uumpy_new(mp_float_t, 3 * n);
+    mp_float_t *y = x + n;
+    mp_float_t *z = y + n;
+    mp_float_t inv_norm = 0;
+
+    for (mp_int_t i=0; i < n; i++) {
+        x[i] = MICROPY_FLOAT_CONST(1.0) / n;
+    }
+
+    for (mp_int_t step=0; step < UUMPY_LINALG_COND_MAX_STEPS; step++) {
+        memcpy(y, x, n * sizeof(mp_float_t));
+        _linalg_lu_solve_float(n, lu, pivot, y, false);
+
+        inv_norm = 0;
+        for (mp_int_t i=0; i < n; i++) {
+            inv_norm += ABS(y[i]);
+            z[i] = (y[i] >= 0) ? 1 : -1;
+        }
+        _linalg_lu_solve_float(n, lu, pivot, z, true);
+
+        mp_int_t j = 0;
+        mp_float_t zx = 0;
+        for (mp_int_t i=0; i < n; i++) {
+            if (ABS(z[i]) > ABS(z[j])) {
+                j = i;
+            }
+            zx += z[i] * x[i];
+        }
+        if (step > 0 && ABS(z[j]) <= zx) {
+            break;
+        }
+
+        memset(x, 0, n * sizeof(mp_float_t));
+        x[j] = 1;
+    }
+
+    // Higham's extra test vector guards against the cases where the
+    // gradient search is fooled
+    mp_float_t alt_norm = 0;
+    for (mp_int_t i=0; i < n; i++) {
+        mp_float_t v = 1 + (n > 1 ? (mp_float_t) i / (n - 1) : 0);
+        x[i] = (i & 1) ? -v : v;
+    }
+    _linalg_lu_solve_float(n, lu, pivot, x, false);
+    for (mp_int_t i=0; i < n; i++) {
+        alt_norm += ABS(x[i]);
+    }
+    alt_norm = 2 * alt_norm / (3 * n);
+
+    m_del(mp_float_t, x, 3 * n);
+    m_del(mp_int_t, pivot, n);
+
+    return UUMPY_BOXED_RESULT(mp_obj_new_float(a_norm * MAX(inv_norm, alt_norm)));
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_linalg_cond_obj, uumpy_linalg_cond);
+
+// Matrix functions. These all work on square matrices copied into
+// contiguous n x n buffers of the default float type, and all of their
+// work space is allocated up front.
+
+// Get a contiguous square copy of the input
+static uumpy_obj_ndarray_t *_linalg_square_copy(mp_obj_t a_in) {
+    uumpy_obj_ndarray_t *a = uumpy_array_from_value(a_in, UUMPY_DEFAULT_TYPE);
+
+    if (a->dim_count != 2 || a->dim_info[0].length != a->dim_info[1].length) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("matrix must be square"));
+    }
+
+    return a;
+}
+
+// C = A B for contiguous n x n matrices. C must not be A or B. The loops
+// are ordered so that the innermost one runs along rows of B and C.
+static void _linalg_gemm(mp_int_t n, const mp_float_t *a, const mp_float_t *b, mp_float_t *c) {
+    memset(c, 0, n * n * sizeof(mp_float_t));
+
+    for (mp_int_t i=0; i < n; i++) {
+        mp_float_t *c_row = c + i * n;
+        for (mp_int_t k=0; k < n; k++) {
+            mp_float_t a_ik = a[i * n + k];
+            if (a_ik == 0) {
+                continue;
+            }
+            const mp_float_t *b_row = b + k * n;
+            for (mp_int_t j=0; j < n; j++) {
+                c_row[j] += a_ik * b_row[j];
+            }
+        }
+    }
+}
 
+static void _linalg_identity(mp_int_t n, mp_float_t *a) {
+    memset(a, 0, n * n * sizeof(mp_float_t));
+    for (mp_int_t i=0; i < n; i++) {
+        a[i * (n + 1)] = 1;
+    }
+}
+
+// The maximum absolute column sum
+static mp_float_t _linalg_norm1(mp_int_t n, const mp_float_t *a) {
+    mp_float_t norm = 0;
+
+    for (mp_int_t j=0; j < n; j++) {
+        mp_float_t sum = 0;
+        for (mp_int_t i=0; i < n; i++) {
+            sum += ABS(a[i * n + j]);
+        }
+        if (sum > norm) {
+            norm = sum;
+        }
+    }
+
+    return norm;
+}
+
+// Compute A^-1 B into dest, using Gauss-Jordan elimination on an n x 2n
+// temp holding [A | B]. B and dest may be the same buffer.
+static void _linalg_left_divide(mp_int_t n, const mp_float_t *a, const mp_float_t *b,
+                                mp_float_t *dest, uumpy_obj_ndarray_t *temp) {
+    mp_float_t *data = (mp_float_t *) temp->data;
+
+    for (mp_int_t i=0; i < n; i++) {
+        memcpy(data + i * 2 * n, a + i * n, n * sizeof(mp_float_t));
+        memcpy(data + i * 2 * n + n, b + i * n, n * sizeof(mp_float_t));
+    }
+
+    if (_uumpy_linalg_reduce_array(temp, true, true, NULL) != (size_t) n) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("singular matrix"));
+    }
+
+    for (mp_int_t i=0; i < n; i++) {
+        memcpy(dest + i * n, data + i * 2 * n + n, n * sizeof(mp_float_t));
+    }
+}
+
+static uumpy_obj_ndarray_t *_linalg_divide_temp(mp_int_t n) {
+    mp_int_t dims[2] = {n, 2 * n};
+
+    return ndarray_new(UUMPY_DEFAULT_TYPE, 2, dims);
+}
+
+#define UUMPY_LINALG_PADE_ORDER (6)
+
+// The matrix exponential by scaling and squaring. A is scaled by a power
+// of two so that its norm is at most 1/2, where the (6, 6) Padé
+// approximant is accurate to double precision, and the result is then
+// squared back up.
+static mp_obj_t uumpy_linalg_expm(mp_obj_t a_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_obj_ndarray_t *a_copy = _linalg_square_copy(a_in);
+    mp_int_t n = a_copy->dim_info[0].length;
+    mp_int_t nn = n * n;
+    mp_int_t dims[2] = {n, n};
+    mp_float_t *a = (mp_float_t *) a_copy->data;
+
+    uumpy_obj_ndarray_t *result = ndarray_new(UUMPY_DEFAULT_TYPE, 2, dims);
+    mp_float_t *e = (mp_float_t *) result->data;
+    mp_float_t *work = uumpy_new(mp_float_t, 3 * nn);
+    mp_float_t *x = work;
+    mp_float_t *numer = work + nn;
+    mp_float_t *tmp = work + 2 * nn;
+    uumpy_obj_ndarray_t *temp = _linalg_divide_temp(n);
+
+    int exponent;
+    FREXP(_linalg_norm1(n, a), &exponent);
+    mp_int_t squarings = MAX(0, exponent + 1);
+    mp_float_t scale = MICROPY_FLOAT_C_FUN(ldexp)(1, -squarings);
+    for (mp_int_t i=0; i < nn; i++) {
+        a[i] *= scale;
+    }
+
+    // The numerator and denominator (in e) only differ in the signs of
+    // the odd powers
+    mp_float_t c = MICROPY_FLOAT_CONST(0.5);
+    memcpy(x, a, nn * sizeof(mp_float_t));
+    _linalg_identity(n, numer);
+    _linalg_identity(n, e);
+    for (mp_int_t i=0; i < nn; i++) {
+        numer[i] += c * x[i];
+        e[i] -= c * x[i];
+    }
+
+    const mp_int_t q = UUMPY_LINALG_PADE_ORDER;
+    for (mp_int_t k=2; k <= q; k++) {
+        c = c * (q - k + 1) / (k * (2 * q - k + 1));
+        _linalg_gemm(n, a, x, tmp);
+        memcpy(x, tmp, nn * sizeof(mp_float_t));
+        mp_float_t sign_c = (k & 1) ? -c : c;
+        for (mp_int_t i=0; i < nn; i++) {
+            numer[i] += c * x[i];
+            e[i] += sign_c * x[i];
+        }
+    }
+
+    _linalg_left_divide(n, e, numer, e, temp);
+
+    for (mp_int_t s=0; s < squarings; s++) {
+        _linalg_gemm(n, e, e, tmp);
+        memcpy(e, tmp, nn * sizeof(mp_float_t));
+    }
+
+    m_del(mp_float_t, work, 3 * nn);
+
+    return MP_OBJ_FROM_PTR(result);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_linalg_expm_obj, uumpy_linalg_expm);
+
+// Raise a square matrix to an integer power by repeated squaring, which
+// takes O(log p) products. Negative powers invert the matrix first.
+static mp_obj_t uumpy_linalg_matrix_power(mp_obj_t a_in, mp_obj_t p_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_obj_ndarray_t *base_array = _linalg_square_copy(a_in);
+    mp_int_t p = mp_obj_get_int(p_in);
+    mp_int_t n = base_array->dim_info[0].length;
+    mp_int_t nn = n * n;
+    mp_int_t dims[2] = {n, n};
+    mp_float_t *base = (mp_float_t *) base_array->data;
+
+    uumpy_obj_ndarray_t *result = ndarray_new(UUMPY_DEFAULT_TYPE, 2, dims);
+    mp_float_t *r = (mp_float_t *) result->data;
+    mp_float_t *tmp = uumpy_new(mp_float_t, nn);
+
+    _linalg_identity(n, r);
+
+    if (p < 0) {
+        _linalg_left_divide(n, base, r, base, _linalg_divide_temp(n));
+        _linalg_identity(n, r);
+        p = -p;
+    }
+
+    while (p) {
+        if (p & 1) {
+            _linalg_gemm(n, r, base, tmp);
+            memcpy(r, tmp, nn * sizeof(mp_float_t));
+        }
+        p >>= 1;
+        if (p) {
+            _linalg_gemm(n, base, base, tmp);
+            memcpy(base, tmp, nn * sizeof(mp_float_t));
+        }
+    }
+
+    m_del(mp_float_t, tmp, nn);
+
+    return MP_OBJ_FROM_PTR(result);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(uumpy_linalg_matrix_power_obj, uumpy_linalg_matrix_power);
+
+#define UUMPY_LINALG_SQRTM_MAX_ITER (50)
+
+// The principal square root by the Denman-Beavers iteration
+//   Y' = (Y + Z^-1) / 2, Z' = (Z + Y^-1) / 2
+// starting from Y = A, Z = I, under which Y converges to sqrt(A). A must
+// not have eigenvalues on the closed negative real axis.
+static mp_obj_t uumpy_linalg_sqrtm(mp_obj_t a_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_obj_ndarray_t *result = _linalg_square_copy(a_in);
+    mp_int_t n = result->dim_info[0].length;
+    mp_int_t nn = n * n;
+    mp_float_t *y = (mp_float_t *) result->data;
+
+    mp_float_t *work = uumpy_new(mp_float_t, 4 * nn);
+    mp_float_t *z = work;
+    mp_float_t *y_inv = work + nn;
+    mp_float_t *z_inv = work + 2 * nn;
+    mp_float_t *ident = work + 3 * nn;
+    uumpy_obj_ndarray_t *temp = _linalg_divide_temp(n);
+
+    _linalg_identity(n, z);
+    _linalg_identity(n, ident);
+
+    bool converged = false;
+    mp_float_t last_change = INFINITY;
+    for (mp_int_t iter=0; iter < UUMPY_LINALG_SQRTM_MAX_ITER; iter++) {
+        _linalg_left_divide(n, y, ident, y_inv, temp);
+        _linalg_left_divide(n, z, ident, z_inv, temp);
+
+        mp_float_t change = 0;
+        mp_float_t size = 0;
+        for (mp_int_t i=0; i < nn; i++) {
+            mp_float_t y_new = (y[i] + z_inv[i]) / 2;
+            change += ABS(y_new - y[i]);
+            size += ABS(y_new);
+            y[i] = y_new;
+            z[i] = (z[i] + y_inv[i]) / 2;
+        }
+
+        if (change <= UUMPY_EPSILON * size) {
+            converged = true;
+            break;
+        }
+        if (change >= last_change) {
+            // The sums of the changes may never get below UUMPY_EPSILON,
+            // so once they stop shrinking we are down to rounding noise,
+            // which is fine so long as it is small
+            converged = (change <= MICROPY_FLOAT_C_FUN(sqrt)(UUMPY_EPSILON) * size);
+            break;
+        }
+        last_change = change;
+    }
+
+    m_del(mp_float_t, work, 4 * nn);
+
+    if (!converged) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("sqrtm did not converge"));
+    }
+
+    return MP_OBJ_FROM_PTR(result);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_linalg_sqrtm_obj, uumpy_linalg_sqrtm);
+
+// Iterative solvers. These only ever use the matrix through its product
+// with a vector, so the matrix can be dense, sparse or a function, and
+// they need O(n) working memory (O(n * restart) for GMRES) rather than
+// the O(n^2) of a direct solve. All the work vectors are allocated once
+// before the iteration starts.
+
+// A linear operator y = A x on vectors of length n. Anything that is not
+// a matrix is called with an ndarray holding x, which is reused for every
+// call, and must return a vector of length n.
+typedef struct _uumpy_linalg_operator {
+    mp_int_t n;
+    uumpy_obj_ndarray_t *matrix;
+#if UUMPY_ENABLE_SPARSE
+    uumpy_sparse_obj_csr_t *sparse;
+#endif
+    mp_obj_t function;
+    uumpy_obj_ndarray_t *arg;
+} uumpy_linalg_operator;
+
+// Get the input as an array of the default float type, without copying
+// it if it already is one
+static uumpy_obj_ndarray_t *_linalg_float_array(mp_obj_t x_in) {
+    if (mp_obj_is_type(x_in, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+        uumpy_obj_ndarray_t *x = MP_OBJ_TO_PTR(x_in);
+        if (x->typecode == UUMPY_DEFAULT_TYPE) {
+            return x;
+        }
+    }
+    return uumpy_array_from_value(x_in, UUMPY_DEFAULT_TYPE);
+}
+
+// Copy a 1-D float array of length n into a contiguous buffer
+static void _linalg_get_vector(mp_float_t *dest, uumpy_obj_ndarray_t *src, mp_int_t n) {
+    if (src->dim_count != 1 || src->dim_info[0].length != n) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("dimensions don't match"));
+    }
+
+    mp_float_t *src_data = ((mp_float_t *) src->data) + src->base_offset;
+    mp_int_t stride = src->dim_info[0].stride;
+
+    for (mp_int_t i=0; i < n; i++) {
+        dest[i] = src_data[i * stride];
+    }
+}
+
+static void _linalg_operator_init(uumpy_linalg_operator *op, mp_obj_t a_in, mp_int_t n) {
+    memset(op, 0, sizeof(*op));
+    op->n = n;
+
+#if UUMPY_ENABLE_SPARSE
+    if (mp_obj_is_type(a_in, &uumpy_sparse_type_csr_matrix)) {
+        op->sparse = MP_OBJ_TO_PTR(a_in);
+        if (op->sparse->rows != n || op->sparse->cols != n) {
+            mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("dimensions don't match"));
+        }
+        return;
+    }
+#endif
+
+    if (!mp_obj_is_type(a_in, MP_OBJ_FROM_PTR(&uumpy_type_ndarray)) && mp_obj_is_callable(a_in)) {
+        op->function = a_in;
+        op->arg = ndarray_new(UUMPY_DEFAULT_TYPE, 1, &n);
+        return;
+    }
+
+    op->matrix = _linalg_float_array(a_in);
+    if (op->matrix->dim_count != 2 ||
+        op->matrix->dim_info[0].length != n || op->matrix->dim_info[1].length != n) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("dimensions don't match"));
+    }
+}
+
+static void _linalg_operator_apply(uumpy_linalg_operator *op, const mp_float_t *x, mp_float_t *y) {
+    mp_int_t n = op->n;
+
+#if UUMPY_ENABLE_SPARSE
+    if (op->sparse) {
+        uumpy_sparse_csr_multiply(op->sparse, false, 1, x, 1, 0, y, 1, 0);
+        return;
+    }
+#endif
+
+    if (op->function != MP_OBJ_NULL) {
+        memcpy(op->arg->data, x, n * sizeof(mp_float_t));
+        mp_obj_t result = mp_call_function_1(op->function, MP_OBJ_FROM_PTR(op->arg));
+        _linalg_get_vector(y, _linalg_float_array(result), n);
+        return;
+    }
+
+    uumpy_obj_ndarray_t *a = op->matrix;
+    mp_float_t *a_data = ((mp_float_t *) a->data) + a->base_offset;
+    mp_int_t row_stride = a->dim_info[0].stride;
+    mp_int_t col_stride = a->dim_info[1].stride;
+
+    for (mp_int_t i=0; i < n; i++) {
+        mp_float_t *row = a_data + i * row_stride;
+        mp_float_t acc = 0;
+        for (mp_int_t j=0; j < n; j++) {
+            acc += row[j * col_stride] * x[j];
+        }
+        y[i] = acc;
+    }
+}
+
+// Get the reciprocals of the diagonal of the operator, for use as a
+// Jacobi preconditioner. Functions don't have a diagonal we can look at,
+// so in that case the caller has to pass it in.
+static void _linalg_jacobi_init(uumpy_linalg_operator *op, mp_obj_t jacobi_in, mp_float_t *inv_diag) {
+    mp_int_t n = op->n;
+
+    if (jacobi_in != mp_const_true) {
+        _linalg_get_vector(inv_diag, _linalg_float_array(jacobi_in), n);
+#if UUMPY_ENABLE_SPARSE
+    } else if (op->sparse) {
+        uumpy_sparse_obj_csr_t *a = op->sparse;
+        for (mp_int_t i=0; i < n; i++) {
+            inv_diag[i] = 0;
+            for (mp_int_t k=a->indptr[i]; k < a->indptr[i + 1]; k++) {
+                if (a->indices[k] == i) {
+                    inv_diag[i] = a->data[k];
+                    break;
+                }
+            }
+        }
+#endif
+    } else if (op->matrix) {
+        uumpy_obj_ndarray_t *a = op->matrix;
+        mp_float_t *a_data = ((mp_float_t *) a->data) + a->base_offset;
+        mp_int_t diag_stride = a->dim_info[0].stride + a->dim_info[1].stride;
+        for (mp_int_t i=0; i < n; i++) {
+            inv_diag[i] = a_data[i * diag_stride];
+        }
+    } else {
+        mp_raise_ValueError(MP_ERROR_TEXT("jacobi must give the diagonal when A is a function"));
+    }
+
+    for (mp_int_t i=0; i < n; i++) {
+        if (inv_diag[i] == 0) {
+            mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("zero on the diagonal"));
+        }
+        inv_diag[i] = 1 / inv_diag[i];
+    }
+}
+
+static mp_float_t _linalg_dot(const mp_float_t *x, const mp_float_t *y, mp_int_t n) {
+    mp_float_t acc = 0;
+
+    for (mp_int_t i=0; i < n; i++) {
+        acc += x[i] * y[i];
+    }
+
+    return acc;
+}
+
+// y += alpha * x
+static void _linalg_axpy(mp_float_t alpha, const mp_float_t *x, mp_float_t *y, mp_int_t n) {
+    for (mp_int_t i=0; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+// y = x * d, element by element
+static void _linalg_scale_by(const mp_float_t *x, const mp_float_t *d, mp_float_t *y, mp_int_t n) {
+    for (mp_int_t i=0; i < n; i++) {
+        y[i] = x[i] * d[i];
+    }
+}
+
+// The arguments are the same for both solvers
+enum {
+    ARG_A,
+    ARG_b,
+    ARG_x0,
+    ARG_tol,
+    ARG_maxiter,
+    ARG_jacobi,
+    ARG_restart,
+};
+static const mp_arg_t uumpy_linalg_iterative_args[] = {
+    { MP_QSTR_A,       MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    { MP_QSTR_b,       MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    { MP_QSTR_x0,      MP_ARG_OBJ,                   {.u_obj = mp_const_none} },
+    { MP_QSTR_tol,     MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    { MP_QSTR_maxiter, MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    { MP_QSTR_jacobi,  MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_false} },
+    { MP_QSTR_restart, MP_ARG_KW_ONLY  | MP_ARG_INT, {.u_int = 20} },
+};
+
+typedef struct _uumpy_linalg_iterative {
+    uumpy_linalg_operator op;
+    mp_int_t n;
+    mp_float_t tol;
+    mp_int_t maxiter;
+    uumpy_obj_ndarray_t *x;
+    mp_float_t *b;
+    mp_float_t *inv_diag;
+    mp_int_t work_size;
+} uumpy_linalg_iterative;
+
+// Parse the arguments and set up the solution, the right hand side and
+// the preconditioner. The caller's work_vectors vectors of length n are
+// allocated in the same block as the ones needed here.
+static mp_float_t *_linalg_iterative_init(uumpy_linalg_iterative *it, mp_arg_val_t *args,
+                                          mp_int_t work_vectors) {
+    uumpy_obj_ndarray_t *b = _linalg_float_array(args[ARG_b].u_obj);
+
+    if (b->dim_count != 1) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("can only solve single set of equations"));
+    }
+
+    mp_int_t n = b->dim_info[0].length;
+    bool use_jacobi = (args[ARG_jacobi].u_obj != mp_const_false && args[ARG_jacobi].u_obj != mp_const_none);
+
+    it->n = n;
+    _linalg_operator_init(&it->op, args[ARG_A].u_obj, n);
+    it->tol = (args[ARG_tol].u_obj == mp_const_none) ?
+        MICROPY_FLOAT_CONST(1e-5) : mp_obj_get_float(args[ARG_tol].u_obj);
+    // info reports a failure as the number of iterations run, so there
+    // has to be at least one
+    it->maxiter = (args[ARG_maxiter].u_obj == mp_const_none) ?
+        MAX(10 * n, 1) : mp_obj_get_int(args[ARG_maxiter].u_obj);
+    if (it->maxiter < 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("maxiter must be >= 1"));
+    }
+
+    it->work_size = (work_vectors + 1 + (use_jacobi ? 1 : 0)) * n;
+    mp_float_t *work = uumpy_new(mp_float_t, it->work_size);
+    it->b = work + work_vectors * n;
+    it->inv_diag = use_jacobi ? it->b + n : NULL;
+
+    _linalg_get_vector(it->b, b, n);
+    if (use_jacobi) {
+        _linalg_jacobi_init(&it->op, args[ARG_jacobi].u_obj, it->inv_diag);
+    }
+
+    it->x = ndarray_new(UUMPY_DEFAULT_TYPE, 1, &n);
+    if (args[ARG_x0].u_obj == mp_const_none) {
+        memset(it->x->data, 0, n * sizeof(mp_float_t));
+    } else {
+        _linalg_get_vector((mp_float_t *) it->x->data, _linalg_float_array(args[ARG_x0].u_obj), n);
+    }
+
+    return work;
+}
+
+static mp_obj_t _linalg_iterative_result(uumpy_linalg_iterative *it, mp_int_t info) {
+    mp_obj_t result[2] = {MP_OBJ_FROM_PTR(it->x), MP_OBJ_NEW_SMALL_INT(info)};
+
+    return mp_obj_new_tuple(2, result);
+}
+
+// Preconditioned conjugate gradients, for symmetric positive definite A.
+// As with scipy the result is a tuple (x, info), where info is 0 if the
+// residual met the tolerance and the number of iterations run otherwise.
+static mp_obj_t uumpy_linalg_cg(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(uumpy_linalg_iterative_args)];
+    // GMRES's restart length means nothing here
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(uumpy_linalg_iterative_args) - 1,
+                     uumpy_linalg_iterative_args, args);
+
+    uumpy_linalg_iterative it;
+    mp_float_t *work = _linalg_iterative_init(&it, args, 4);
+    mp_int_t n = it.n;
+    mp_float_t *x = (mp_float_t *) it.x->data;
+    mp_float_t *r = work;
+    mp_float_t *p = work + n;
+    mp_float_t *ap = work + 2 * n;
+    // Without a preconditioner z is just r
+    mp_float_t *z = it.inv_diag ? work + 3 * n : r;
+
+    // r = b - A x
+    _linalg_operator_apply(&it.op, x, ap);
+    for (mp_int_t i=0; i < n; i++) {
+        r[i] = it.b[i] - ap[i];
+    }
+    if (it.inv_diag) {
+        _linalg_scale_by(r, it.inv_diag, z, n);
+    }
+    memcpy(p, z, n * sizeof(mp_float_t));
+
+    mp_float_t threshold = it.tol * it.tol * _linalg_dot(it.b, it.b, n);
+    mp_float_t rz = _linalg_dot(r, z, n);
+    mp_int_t info = 0;
+
+    for (mp_int_t iter=0; _linalg_dot(r, r, n) > threshold; iter++) {
+        if (iter == it.maxiter) {
+            info = iter;
+            break;
+        }
+
+        _linalg_operator_apply(&it.op, p, ap);
+        mp_float_t pap = _linalg_dot(p, ap, n);
+        if (pap <= 0) {
+            mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("matrix is not positive definite"));
+        }
+
+        mp_float_t alpha = rz / pap;
+        _linalg_axpy(alpha, p, x, n);
+        _linalg_axpy(-alpha, ap, r, n);
+        if (it.inv_diag) {
+            _linalg_scale_by(r, it.inv_diag, z, n);
+        }
+
+        mp_float_t rz_new = _linalg_dot(r, z, n);
+        mp_float_t beta = rz_new / rz;
+        for (mp_int_t i=0; i < n; i++) {
+            p[i] = z[i] + beta * p[i];
+        }
+        rz = rz_new;
+    }
+
+    m_del(mp_float_t, work, it.work_size);
+
+    return _linalg_iterative_result(&it, info);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_linalg_cg_obj, 2, uumpy_linalg_cg);
+
+// Restarted GMRES for general non-singular A. The Krylov basis is built
+// with modified Gram-Schmidt and the small least squares problem is kept
+// in triangular form with Givens rotations, so the residual norm is known
+// at every step without forming x. Jacobi preconditioning is applied on
+// the right so that the residual being tested is the true one.
+static mp_obj_t uumpy_linalg_gmres(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(uumpy_linalg_iterative_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(uumpy_linalg_iterative_args),
+                     uumpy_linalg_iterative_args, args);
+
+    mp_int_t m = args[ARG_restart].u_int;
+    if (m < 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("restart must be >= 1"));
+    }
+
+    uumpy_linalg_iterative it;
+    // The basis vectors V and one more for the preconditioned vector
+    mp_float_t *work = _linalg_iterative_init(&it, args, m + 2);
+    mp_int_t n = it.n;
+    mp_float_t *x = (mp_float_t *) it.x->data;
+    mp_float_t *v = work;
+    mp_float_t *z = work + (m + 1) * n;
+
+    // The Hessenberg matrix, rotations and the rotated residual vector
+    mp_float_t *h = uumpy_new(mp_float_t, (m + 1) * m + 3 * m + 1);
+    mp_float_t *cs = h + (m + 1) * m;
+    mp_float_t *sn = cs + m;
+    mp_float_t *g = sn + m;
+
+    mp_float_t threshold = it.tol * SQRT(_linalg_dot(it.b, it.b, n));
+    mp_int_t iter = 0;
+    mp_int_t info = 0;
+
+    while (true) {
+        // v0 = b - A x
+        _linalg_operator_apply(&it.op, x, v);
+        for (mp_int_t i=0; i < n; i++) {
+            v[i] = it.b[i] - v[i];
+        }
+
+        mp_float_t beta = SQRT(_linalg_dot(v, v, n));
+        if (beta <= threshold) {
+            break;
+        }
+        if (iter == it.maxiter) {
+            info = iter;
+            break;
+        }
+
+        for (mp_int_t i=0; i < n; i++) {
+            v[i] /= beta;
+        }
+        memset(g, 0, (m + 1) * sizeof(mp_float_t));
+        g[0] = beta;
+
+        mp_int_t k = 0;
+        while (k < m && iter < it.maxiter) {
+            mp_float_t *vk = v + k * n;
+            mp_float_t *w = vk + n;
+            iter++;
+
+            if (it.inv_diag) {
+                _linalg_scale_by(vk, it.inv_diag, z, n);
+                _linalg_operator_apply(&it.op, z, w);
+            } else {
+                _linalg_operator_apply(&it.op, vk, w);
+            }
+
+            // Column k of H is stored as h[i * m + k]
+            for (mp_int_t i=0; i <= k; i++) {
+                mp_float_t hik = _linalg_dot(w, v + i * n, n);
+                h[i * m + k] = hik;
+                _linalg_axpy(-hik, v + i * n, w, n);
+            }
+            mp_float_t w_norm = SQRT(_linalg_dot(w, w, n));
+            if (w_norm != 0) {
+                for (mp_int_t i=0; i < n; i++) {
+                    w[i] /= w_norm;
+                }
+            }
+
+            for (mp_int_t i=0; i < k; i++) {
+                mp_float_t a = h[i * m + k];
+                mp_float_t b = h[(i + 1) * m + k];
+                h[i * m + k] = cs[i] * a + sn[i] * b;
+                h[(i + 1) * m + k] = cs[i] * b - sn[i] * a;
+            }
+
+            mp_float_t a = h[k * m + k];
+            mp_float_t r = SQRT(a * a + w_norm * w_norm);
+            if (r == 0) {
+                cs[k] = 1;
+                sn[k] = 0;
+            } else {
+                cs[k] = a / r;
+                sn[k] = w_norm / r;
+            }
+            h[k * m + k] = r;
+            g[k + 1] = -sn[k] * g[k];
+            g[k] = cs[k] * g[k];
+            k++;
+
+            if (ABS(g[k]) <= threshold || w_norm == 0) {
+                break;
+            }
+        }
+
+        // Solve the triangular system H y = g in place in g and update x
+        for (mp_int_t i=k - 1; i >= 0; i--) {
+            mp_float_t acc = g[i];
+            for (mp_int_t j=i + 1; j < k; j++) {
+                acc -= h[i * m + j] * g[j];
+            }
+            if (h[i * m + i] == 0) {
+                mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("singular matrix"));
+            }
+            g[i] = acc / h[i * m + i];
+        }
+
+        if (it.inv_diag) {
+            memset(z, 0, n * sizeof(mp_float_t));
+            for (mp_int_t i=0; i < k; i++) {
+                _linalg_axpy(g[i], v + i * n, z, n);
+            }
+            for (mp_int_t i=0; i < n; i++) {
+                x[i] += it.inv_diag[i] * z[i];
+            }
+        } else {
+            for (mp_int_t i=0; i < k; i++) {
+                _linalg_axpy(g[i], v + i * n, x, n);
+            }
+        }
+    }
+
+    m_del(mp_float_t, h, (m + 1) * m + 3 * m + 1);
+    m_del(mp_float_t, work, it.work_size);
+
+    return _linalg_iterative_result(&it, info);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_linalg_gmres_obj, 2, uumpy_linalg_gmres);
+
+// Direct solvers for structured systems. These work in O(n * bandwidth)
+// time and, when asked to overwrite their inputs, without allocating.
+// The right hand side b can be a vector or a matrix with one column per
+// system, and the solution takes the same shape.
+
+// Get an array that can be modified. With overwrite set, a float ndarray
+// is used as it is and other inputs are copied.
+static uumpy_obj_ndarray_t *_linalg_writable_array(mp_obj_t x_in, bool overwrite) {
+    if (overwrite && mp_obj_is_type(x_in, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+        uumpy_obj_ndarray_t *x = MP_OBJ_TO_PTR(x_in);
+        if (x->typecode == UUMPY_DEFAULT_TYPE) {
+            return x;
+        }
+    }
+    return uumpy_array_from_value(x_in, UUMPY_DEFAULT_TYPE);
+}
+
+// Check that b has n rows and return the number of columns
+static mp_int_t _linalg_rhs_columns(uumpy_obj_ndarray_t *b, mp_int_t n) {
+    if (b->dim_count < 1 || b->dim_count > 2 || b->dim_info[0].length != n) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("dimensions don't match"));
+    }
+
+    return (b->dim_count == 2) ? b->dim_info[1].length : 1;
+}
+
+static mp_int_t _linalg_rhs_column_stride(uumpy_obj_ndarray_t *b) {
+    return (b->dim_count == 2) ? b->dim_info[1].stride : 0;
+}
+
+// Check that v is a vector of length n
+static uumpy_obj_ndarray_t *_linalg_check_vector(uumpy_obj_ndarray_t *v, mp_int_t n) {
+    if (v->dim_count != 1 || v->dim_info[0].length != n) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("dimensions don't match"));
+    }
+
+    return v;
+}
+
+// Solve a x = b where a is triangular, by forward or back substitution.
+// Only the relevant triangle of a is read. Solving with the transpose just
+// swaps the strides of a, which turns a lower triangle into an upper one.
+static mp_obj_t uumpy_linalg_solve_triangular(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_a,
+        ARG_b,
+        ARG_trans,
+        ARG_lower,
+        ARG_unit_diagonal,
+        ARG_overwrite_b,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_a,             MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_b,             MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_trans,         MP_ARG_BOOL,                  {.u_bool = false} },
+        { MP_QSTR_lower,         MP_ARG_BOOL,                  {.u_bool = false} },
+        { MP_QSTR_unit_diagonal, MP_ARG_BOOL,                  {.u_bool = false} },
+        { MP_QSTR_overwrite_b,   MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_obj_ndarray_t *a = _linalg_float_array(args[ARG_a].u_obj);
+    if (a->dim_count != 2 || a->dim_info[0].length != a->dim_info[1].length) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("equation matrix must be square"));
+    }
+
+    mp_int_t n = a->dim_info[0].length;
+    uumpy_obj_ndarray_t *b = _linalg_writable_array(args[ARG_b].u_obj, args[ARG_overwrite_b].u_bool);
+    mp_int_t columns = _linalg_rhs_columns(b, n);
+
+    mp_float_t *a_data = ((mp_float_t *) a->data) + a->base_offset;
+    mp_int_t a_rs = a->dim_info[0].stride;
+    mp_int_t a_cs = a->dim_info[1].stride;
+    bool lower = args[ARG_lower].u_bool;
+    bool unit = args[ARG_unit_diagonal].u_bool;
+
+    if (args[ARG_trans].u_bool) {
+        mp_int_t t = a_rs;
+        a_rs = a_cs;
+        a_cs = t;
+        lower = !lower;
+    }
+
+    if (!unit) {
+        for (mp_int_t i=0; i < n; i++) {
+            if (a_data[i * (a_rs + a_cs)] == 0) {
+                mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("singular matrix"));
+            }
+        }
+    }
+
+    mp_int_t b_rs = b->dim_info[0].stride;
+    mp_int_t b_cs = _linalg_rhs_column_stride(b);
+
+    for (mp_int_t c=0; c < columns; c++) {
+        mp_float_t *x = ((mp_float_t *) b->data) + b->base_offset + c * b_cs;
+
+        for (mp_int_t k=0; k < n; k++) {
+            mp_int_t i = lower ? k : n - 1 - k;
+            mp_float_t *row = a_data + i * a_rs;
+            mp_float_t acc = x[i * b_rs];
+
+            if (lower) {
+                for (mp_int_t j=0; j < i; j++) {
+                    acc -= row[j * a_cs] * x[j * b_rs];
+                }
+            } else {
+                for (mp_int_t j=i + 1; j < n; j++) {
+                    acc -= row[j * a_cs] * x[j * b_rs];
+                }
+            }
+
+            x[i * b_rs] = unit ? acc : acc / row[i * a_cs];
+        }
+    }
+
+    return MP_OBJ_FROM_PTR(b);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_linalg_solve_triangular_obj, 2, uumpy_linalg_solve_triangular);
+
+// Solve a banded system held in the same band storage as scipy, where
+// a[i, j] is kept in ab[u + i - j, j]. The LU factors are computed in
+// place in ab without pivoting, so that no fill-in is created outside
+// the band. That suits the diagonally dominant and positive definite
+// systems that splines and smoothing produce, but a zero pivot raises
+// LinAlgError.
+static mp_obj_t uumpy_linalg_solve_banded(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_l_and_u,
+        ARG_ab,
+        ARG_b,
+        ARG_overwrite_ab,
+        ARG_overwrite_b,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_l_and_u,      MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_ab,           MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_b,            MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_overwrite_ab, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+        { MP_QSTR_overwrite_b,  MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_obj_t *l_and_u;
+    mp_obj_get_array_fixed_n(args[ARG_l_and_u].u_obj, 2, &l_and_u);
+    mp_int_t l = mp_obj_get_int(l_and_u[0]);
+    mp_int_t u = mp_obj_get_int(l_and_u[1]);
+    if (l < 0 || u < 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("l and u must be >= 0"));
+    }
+
+    uumpy_obj_ndarray_t *ab = _linalg_writable_array(args[ARG_ab].u_obj, args[ARG_overwrite_ab].u_bool);
+    if (ab->dim_count != 2 || ab->dim_info[0].length != l + u + 1) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("ab must have l + u + 1 rows"));
+    }
+
+    mp_int_t n = ab->dim_info[1].length;
+    uumpy_obj_ndarray_t *b = _linalg_writable_array(args[ARG_b].u_obj, args[ARG_overwrite_b].u_bool);
+    mp_int_t columns = _linalg_rhs_columns(b, n);
+
+    mp_float_t *ab_data = ((mp_float_t *) ab->data) + ab->base_offset;
+    mp_int_t ab_rs = ab->dim_info[0].stride;
+    mp_int_t ab_cs = ab->dim_info[1].stride;
+
+    #define AB(i, j) ab_data[(u + (i) - (j)) * ab_rs + (j) * ab_cs]
+
+    for (mp_int_t k=0; k < n; k++) {
+        mp_float_t pivot = AB(k, k);
+        if (pivot == 0) {
+            mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("singular matrix"));
+        }
+
+        mp_int_t i_end = MIN(n, k + l + 1);
+        mp_int_t j_end = MIN(n, k + u + 1);
+        for (mp_int_t i=k + 1; i < i_end; i++) {
+            mp_float_t multiple = AB(i, k) / pivot;
+            AB(i, k) = multiple;
+            for (mp_int_t j=k + 1; j < j_end; j++) {
+                AB(i, j) -= multiple * AB(k, j);
+            }
+        }
+    }
+
+    mp_int_t b_rs = b->dim_info[0].stride;
+    mp_int_t b_cs = _linalg_rhs_column_stride(b);
+
+    for (mp_int_t c=0; c < columns; c++) {
+        mp_float_t *x = ((mp_float_t *) b->data) + b->base_offset + c * b_cs;
+
+        // L has a unit diagonal
+        for (mp_int_t i=1; i < n; i++) {
+            mp_float_t acc = x[i * b_rs];
+            for (mp_int_t j=MAX(0, i - l); j < i; j++) {
+                acc -= AB(i, j) * x[j * b_rs];
+            }
+            x[i * b_rs] = acc;
+        }
+
+        for (mp_int_t i=n - 1; i >= 0; i--) {
+            mp_float_t acc = x[i * b_rs];
+            mp_int_t j_end = MIN(n, i + u + 1);
+            for (mp_int_t j=i + 1; j < j_end; j++) {
+                acc -= AB(i, j) * x[j * b_rs];
+            }
+            x[i * b_rs] = acc / AB(i, i);
+        }
+    }
+
+    #undef AB
+
+    return MP_OBJ_FROM_PTR(b);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_linalg_solve_banded_obj, 3, uumpy_linalg_solve_banded);
+
+// Solve a tridiagonal system with the Thomas algorithm in O(n). dl and du
+// are the n - 1 entries below and above the main diagonal d. The forward
+// sweep changes d and b, so these are copied unless overwrite is set.
+// There is no pivoting, as for solve_banded.
+static mp_obj_t uumpy_linalg_solve_tridiagonal(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_dl,
+        ARG_d,
+        ARG_du,
+        ARG_b,
+        ARG_overwrite,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_dl,        MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_d,         MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_du,        MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_b,         MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_overwrite, MP_ARG_KW_ONLY  | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    bool overwrite = args[ARG_overwrite].u_bool;
+    uumpy_obj_ndarray_t *d = _linalg_writable_array(args[ARG_d].u_obj, overwrite);
+    if (d->dim_count != 1 || d->dim_info[0].length == 0) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("d must be a non-empty vector"));
+    }
+
+    mp_int_t n = d->dim_info[0].length;
+    uumpy_obj_ndarray_t *dl = _linalg_check_vector(_linalg_float_array(args[ARG_dl].u_obj), n - 1);
+    uumpy_obj_ndarray_t *du = _linalg_check_vector(_linalg_float_array(args[ARG_du].u_obj), n - 1);
+    uumpy_obj_ndarray_t *b = _linalg_writable_array(args[ARG_b].u_obj, overwrite);
+    mp_int_t columns = _linalg_rhs_columns(b, n);
+
+    mp_float_t *dl_data = ((mp_float_t *) dl->data) + dl->base_offset;
+    mp_float_t *d_data = ((mp_float_t *) d->data) + d->base_offset;
+    mp_float_t *du_data = ((mp_float_t *) du->data) + du->base_offset;
+    mp_float_t *b_data = ((mp_float_t *) b->data) + b->base_offset;
+    mp_int_t dl_s = dl->dim_info[0].stride;
+    mp_int_t d_s = d->dim_info[0].stride;
+    mp_int_t du_s = du->dim_info[0].stride;
+    mp_int_t b_rs = b->dim_info[0].stride;
+    mp_int_t b_cs = _linalg_rhs_column_stride(b);
+
+    for (mp_int_t i=1; i < n; i++) {
+        mp_float_t prev = d_data[(i - 1) * d_s];
+        if (prev == 0) {
+            mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("singular matrix"));
+        }
+        mp_float_t w = dl_data[(i - 1) * dl_s] / prev;
+        d_data[i * d_s] -= w * du_data[(i - 1) * du_s];
+        for (mp_int_t c=0; c < columns; c++) {
+            b_data[i * b_rs + c * b_cs] -= w * b_data[(i - 1) * b_rs + c * b_cs];
+        }
+    }
+    if (d_data[(n - 1) * d_s] == 0) {
+        mp_raise_msg(&uumpy_linalg_type_LinAlgError, MP_ERROR_TEXT("singular matrix"));
+    }
+
+    for (mp_int_t c=0; c < columns; c++) {
+        mp_float_t *x = b_data + c * b_cs;
+        x[(n - 1) * b_rs] /= d_data[(n - 1) * d_s];
+        for (mp_int_t i=n - 2; i >= 0; i--) {
+            x[i * b_rs] = (x[i * b_rs] - du_data[i * du_s] * x[(i + 1) * b_rs]) / d_data[i * d_s];
+        }
+    }
+
+    return MP_OBJ_FROM_PTR(b);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_linalg_solve_tridiagonal_obj, 4, uumpy_linalg_solve_tridiagonal);
 
 static const mp_rom_map_elem_t uumpy_linalg_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_re), MP_ROM_PTR(&uumpy_linalg_re_obj) },
     { MP_ROM_QSTR(MP_QSTR_det), MP_ROM_PTR(&uumpy_linalg_det_obj) },
     { MP_ROM_QSTR(MP_QSTR_inv), MP_ROM_PTR(&uumpy_linalg_inv_obj) },
     { MP_ROM_QSTR(MP_QSTR_solve), MP_ROM_PTR(&uumpy_linalg_solve_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cond), MP_ROM_PTR(&uumpy_linalg_cond_obj) },
+    { MP_ROM_QSTR(MP_QSTR_expm), MP_ROM_PTR(&uumpy_linalg_expm_obj) },
+    { MP_ROM_QSTR(MP_QSTR_matrix_power), MP_ROM_PTR(&uumpy_linalg_matrix_power_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sqrtm), MP_ROM_PTR(&uumpy_linalg_sqrtm_obj) },
+    { MP_ROM_QSTR(MP_QSTR_solve_triangular), MP_ROM_PTR(&uumpy_linalg_solve_triangular_obj) },
+    { MP_ROM_QSTR(MP_QSTR_solve_banded), MP_ROM_PTR(&uumpy_linalg_solve_banded_obj) },
+    { MP_ROM_QSTR(MP_QSTR_solve_tridiagonal), MP_ROM_PTR(&uumpy_linalg_solve_tridiagonal_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cg), MP_ROM_PTR(&uumpy_linalg_cg_obj) },
+    { MP_ROM_QSTR(MP_QSTR_gmres), MP_ROM_PTR(&uumpy_linalg_gmres_obj) },
 // inner
 // outer
 // QR
@@ -34,6 +34,9 @@
 extern const mp_obj_type_t uumpy_linalg_type_LinAlgError;
 extern const mp_obj_module_t uumpy_linalg_module;
 
+MP_DECLARE_CONST_FUN_OBJ_KW(uumpy_linalg_cg_obj);
+MP_DECLARE_CONST_FUN_OBJ_KW(uumpy_linalg_gmres_obj);
+
 #endif // UUMPY_ENABLE_LINALG
 
 #endif // UUMPY_INCLUDED_LINALG_H
@@ -1,11 +1,14 @@
 add_library(uumpy INTERFACE)
 
 target_sources(uumpy INTERFACE
+        ${CMAKE_CURRENT_LIST_DIR}/graph.c
         ${CMAKE_CURRENT_LIST_DIR}/linalg.c
         ${CMAKE_CURRENT_LIST_DIR}/moduumpy.c
         ${CMAKE_CURRENT_LIST_DIR}/reductions.c
         ${CMAKE_CURRENT_LIST_DIR}/ufunc.c
         ${CMAKE_CURRENT_LIST_DIR}/uumath.c
+        ${CMAKE_CURRENT_LIST_DIR}/uusignal.c
+        ${CMAKE_CURRENT_LIST_DIR}/uusparse.c
 )
 
 target_include_directories(uumpy INTERFACE
@@ -31,6 +31,9 @@ SRC_USERMOD += $(UUMPY_MOD_DIR)/ufunc.c
 SRC_USERMOD += $(UUMPY_MOD_DIR)/uumath.c
 SRC_USERMOD += $(UUMPY_MOD_DIR)/linalg.c
 SRC_USERMOD += $(UUMPY_MOD_DIR)/reductions.c
+SRC_USERMOD += $(UUMPY_MOD_DIR)/uusignal.c
+SRC_USERMOD += $(UUMPY_MOD_DIR)/uusparse.c
+SRC_USERMOD += $(UUMPY_MOD_DIR)/graph.c
 
 # Add our module folder to include path
 CFLAGS_USERMOD += -I$(UUMPY_MOD_DIR)
@@ -29,6 +29,7 @@
 // Include required definitions first.
 
 #include <math.h>
+#include <string.h>
 
 #include "py/obj.h"
 #include "py/runtime.h"
@@ -40,7 +41,10 @@
 #include "ufunc.h"
 #include "uumath.h"
 #include "linalg.h"
+#include "uusignal.h"
+#include "uusparse.h"
 #include "reductions.h"
+#include "graph.h"
 
 static mp_obj_t ndarray_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t rhs_in);
 static uumpy_obj_ndarray_t *ndarray_new_0d(mp_obj_t value, char typecode);
@@ -132,6 +136,8 @@ static uumpy_obj_ndarray_t *ndarray_dot_impl(uumpy_obj_ndarray_t *lhs, uumpy_obj
                                                MP_OBJ_FROM_PTR(rhs)));
     }
 
+    UUMPY_GRAPH_UNRECORDABLE();
+
     uumpy_obj_ndarray_t *result = NULL;
 
     // TODO: Select function based on type
@@ -263,10 +269,154 @@ static void ndarray_print(const mp_print_t *print, mp_obj_t o_in, mp_print_kind_
     mp_printf(print, ", dtype='%c')", o->typecode);
 }
 
+#if UUMPY_POOL_SIZE
+
+// Arrays that have been given back are kept whole, header, dimensions and
+// data, and handed out again by ndarray_new() for a new array with the same
+// number of dimensions and the same data size. The slots are a GC root so
+// that the buffers stay alive while they wait.
+MP_REGISTER_ROOT_POINTER(struct _uumpy_obj_ndarray_t *uumpy_pool[UUMPY_POOL_SIZE]);
+
+static size_t uumpy_pool_next = 0;
+
+// A scope records the arrays made while it is active and gives them all
+// back when it exits. Scopes nest; the active one is held by its with
+// statement so it doesn't need to be a root.
+typedef struct _uumpy_obj_scope_t {
+    mp_obj_base_t base;
+    struct _uumpy_obj_scope_t *parent;
+    size_t count;
+    size_t alloc;
+    uumpy_obj_ndarray_t **arrays;
+} uumpy_obj_scope_t;
+
+static uumpy_obj_scope_t *uumpy_scope_current = NULL;
+
+static size_t ndarray_data_size(uumpy_obj_ndarray_t *o) {
+    size_t size = mp_binary_get_size('@', o->typecode, NULL);
+
+    for (mp_int_t i=0; i < o->dim_count; i++) {
+        size *= o->dim_info[i].length;
+    }
+
+    return size;
+}
+
+static uumpy_obj_ndarray_t *ndarray_pool_take(mp_int_t dim_count, size_t data_size) {
+    uumpy_obj_ndarray_t **pool = MP_STATE_VM(uumpy_pool);
+
+    for (size_t i=0; i < UUMPY_POOL_SIZE; i++) {
+        uumpy_obj_ndarray_t *o = pool[i];
+        if (o != NULL && o->dim_count == dim_count && ndarray_data_size(o) == data_size) {
+            pool[i] = NULL;
+            // New arrays start out zeroed
+            memset(o->data, 0, data_size);
+            return o;
+        }
+    }
+
+    return NULL;
+}
+
+// Only arrays that own their data can be recycled. Once given back an
+// array stops counting as simple, which also stops it going in twice.
+static bool ndarray_pool_put(uumpy_obj_ndarray_t *o) {
+    if (!o->simple) {
+        return false;
+    }
+
+    uumpy_obj_ndarray_t **pool = MP_STATE_VM(uumpy_pool);
+    size_t slot = UUMPY_POOL_SIZE;
+
+    for (size_t i=0; i < UUMPY_POOL_SIZE; i++) {
+        if (pool[i] == NULL) {
+            slot = i;
+            break;
+        }
+    }
+
+    // When the pool is full the oldest entries are left to the GC
+    if (slot == UUMPY_POOL_SIZE) {
+        slot = uumpy_pool_next;
+        uumpy_pool_next = (uumpy_pool_next + 1) % UUMPY_POOL_SIZE;
+    }
+
+    o->simple = 0;
+    pool[slot] = o;
+
+    return true;
+}
+
+static void uumpy_scope_record(uumpy_obj_scope_t *scope, uumpy_obj_ndarray_t *o) {
+    if (scope->count == scope->alloc) {
+        size_t new_alloc = scope->alloc ? 2 * scope->alloc : 8;
+        scope->arrays = uumpy_renew(uumpy_obj_ndarray_t *, scope->arrays, scope->alloc, new_alloc);
+        scope->alloc = new_alloc;
+    }
+
+    scope->arrays[scope->count++] = o;
+}
+
+#endif // UUMPY_POOL_SIZE
+
+// The pool slots, the active scope and the other module state outlive the
+// heap, since mp_init() doesn't clear root pointers. Ports must call this
+// from their soft reset path so that nothing is taken from the old heap.
+void uumpy_soft_reset(void) {
+    #if UUMPY_POOL_SIZE
+    for (size_t i=0; i < UUMPY_POOL_SIZE; i++) {
+        MP_STATE_VM(uumpy_pool)[i] = NULL;
+    }
+    uumpy_pool_next = 0;
+    uumpy_scope_current = NULL;
+    #endif
+
+    #if UUMPY_ENABLE_NOALLOC
+    uumpy_noalloc_depth = 0;
+    #endif
+
+    #if UUMPY_ENABLE_GRAPH
+    uumpy_graph_recording = NULL;
+    #endif
+}
+
+static void ndarray_alloc_data(uumpy_obj_ndarray_t *o, size_t size) {
+    #if UUMPY_DATA_OVERALIGNED
+    if (UUMPY_DATA_ALIGNMENT > MICROPY_BYTES_PER_GC_BLOCK) {
+        byte *block = uumpy_new(byte, size + UUMPY_DATA_ALIGNMENT - 1);
+        o->alloc = block;
+        o->data = (void *) (((uintptr_t) block + UUMPY_DATA_ALIGNMENT - 1) & ~((uintptr_t) UUMPY_DATA_ALIGNMENT - 1));
+        return;
+    }
+    #endif
+
+    o->data = uumpy_new(byte, size);
+    #if UUMPY_DATA_OVERALIGNED
+    o->alloc = o->data;
+    #endif
+}
+
 uumpy_obj_ndarray_t *ndarray_new(char typecode, mp_int_t dim_count, mp_int_t *dims) {
     int typecode_size = mp_binary_get_size('@', typecode, NULL);
+    mp_int_t total_count = 1;
+
+    for (mp_int_t i=0; i < dim_count; i++) {
+        total_count *= dims[i];
+    }
+
+    uumpy_obj_ndarray_t *o = NULL;
+
+    #if UUMPY_POOL_SIZE
+    o = ndarray_pool_take(dim_count, typecode_size * total_count);
+    #endif
+
+    if (o == NULL) {
+        o = uumpy_new_obj(uumpy_obj_ndarray_t);
+        o->dim_info = uumpy_new(uumpy_dim_info, dim_count);
+        // DEBUG_printf("Allocating new array type %c, dim_count=%d, total_count=%d\n", typecode, dim_count, total_count);
+        ndarray_alloc_data(o, typecode_size * total_count);
+    }
 
-    uumpy_obj_ndarray_t *o = m_new_obj(uumpy_obj_ndarray_t);
     o->base.type = &uumpy_type_ndarray;
     o->typecode = typecode;
     o->dim_count = dim_count;
@@ -274,19 +424,25 @@ uumpy_obj_ndarray_t *ndarray_new(char typecode, mp_int_t dim_count, mp_int_t *di
     o->simple = 1;
     o->free = 0;
     o->base_offset = 0;
-    o->dim_info = m_new(uumpy_dim_info, dim_count);
 
-    mp_int_t total_count = 1;
+    mp_int_t stride = 1;
 
     for (mp_int_t i = dim_count-1; i >= 0; i--) {
         o->dim_info[i].length = dims[i];
-        o->dim_info[i].stride = total_count;
-        total_count *= dims[i];
+        o->dim_info[i].stride = stride;
+        stride *= dims[i];
     }
 
-    // DEBUG_printf("Allocating new array type %c, dim_count=%d, total_count=%d\n", typecode, dim_count, total_count);
-    
-    o->data = m_new(byte, typecode_size * total_count);
+    #if UUMPY_POOL_SIZE
+    // Arrays made while a graph is recording belong to the graph
+    #if UUMPY_ENABLE_GRAPH
+    if (uumpy_scope_current && !uumpy_graph_recording) {
+    #else
+    if (uumpy_scope_current) {
+    #endif
+        uumpy_scope_record(uumpy_scope_current, o);
+    }
+    #endif
 
     return o;
 }
@@ -305,18 +461,21 @@ uumpy_obj_ndarray_t *ndarray_new_shaped_like(char typecode, uumpy_obj_ndarray_t
 
 uumpy_obj_ndarray_t *ndarray_new_view(uumpy_obj_ndarray_t *source, mp_int_t new_base,
                                       mp_int_t new_dim_count, uumpy_dim_info *new_dims) {
-    uumpy_obj_ndarray_t *o = m_new_obj(uumpy_obj_ndarray_t);
+    uumpy_obj_ndarray_t *o = uumpy_new_obj(uumpy_obj_ndarray_t);
     o->base.type = &uumpy_type_ndarray;
     o->dim_count = new_dim_count;
     o->typecode = source->typecode;
     o->simple = 0; // We could improve on this...
     o->free = 0;
     o->base_offset = new_base;
-    o->dim_info = m_new(uumpy_dim_info, new_dim_count);
+    o->dim_info = uumpy_new(uumpy_dim_info, new_dim_count);
     for (mp_int_t i=0; i < new_dim_count; i++) {
         o->dim_info[i] = new_dims[i];
     }
     o->data = source->data;
+    #if UUMPY_DATA_OVERALIGNED
+    o->alloc = source->alloc;
+    #endif
     return o;
 }
 
@@ -348,7 +507,7 @@ static uumpy_obj_ndarray_t *ndarray_new_1d_from_iterable(mp_obj_t value, mp_int_
 }
 
 static uumpy_obj_ndarray_t *ndarray_new_0d(mp_obj_t value, char typecode) {
-    uumpy_obj_ndarray_t *o = m_new_obj(uumpy_obj_ndarray_t);
+    uumpy_obj_ndarray_t *o = uumpy_new_obj(uumpy_obj_ndarray_t);
     int typecode_size = mp_binary_get_size('@', typecode, NULL);
 
     o->base.type = &uumpy_type_ndarray;
@@ -359,16 +518,60 @@ static uumpy_obj_ndarray_t *ndarray_new_0d(mp_obj_t value, char typecode) {
     o->base_offset = 0;
 
     o->dim_info = NULL;
-    o->data = m_new(byte, typecode_size);
+    ndarray_alloc_data(o, typecode_size);
 
     mp_binary_set_val_array(o->typecode, o->data, 0, value);
 
     return o;
 }
 
+uumpy_obj_ndarray_t *ndarray_init_scalar(uumpy_scalar *scalar, char typecode) {
+    uumpy_obj_ndarray_t *o = &scalar->array;
+
+    o->base.type = &uumpy_type_ndarray;
+    o->dim_count = 0;
+    o->typecode = typecode;
+    o->simple = 0;
+    o->free = 0;
+    o->base_offset = 0;
+    o->dim_info = NULL;
+    o->data = &scalar->value;
+    #if UUMPY_DATA_OVERALIGNED
+    o->alloc = NULL;
+    #endif
+
+    return o;
+}
+
+// Numbers mixed with arrays become 0-d arrays in the caller's storage, so
+// that they don't cost an allocation. Anything else gets a new array, as
+// does everything while a graph is recording since graphs keep pointers to
+// their operands' data.
+uumpy_obj_ndarray_t *ndarray_operand_from_value(mp_obj_t value, char typecode, uumpy_scalar *scalar) {
+    if (mp_obj_is_type(value, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+        return MP_OBJ_TO_PTR(value);
+    }
+
+#if UUMPY_ENABLE_GRAPH
+    if (uumpy_graph_recording) {
+        return uumpy_array_from_value(value, typecode);
+    }
+#endif
+
+    if (mp_obj_is_int(value) || mp_obj_is_float(value) || mp_obj_is_bool(value)) {
+        uumpy_obj_ndarray_t *o = ndarray_init_scalar(scalar, typecode);
+        mp_binary_set_val_array(typecode, o->data, 0, value);
+        return o;
+    }
+
+    return uumpy_array_from_value(value, typecode);
+}
+
+// While a graph is recording the value would be frozen into the graph
 static mp_obj_t ndarray_get_obj_or_0d(uumpy_obj_ndarray_t *o) {
     if (o->dim_count == 0) {
-        return mp_binary_get_val_array(o->typecode, o->data, o->base_offset);
+        UUMPY_GRAPH_UNRECORDABLE();
+        return UUMPY_BOXED_RESULT(mp_binary_get_val_array(o->typecode, o->data, o->base_offset));
     } else {
         return MP_OBJ_FROM_PTR(o);
     }
@@ -435,6 +638,8 @@ static uumpy_obj_ndarray_t *ndarray_from_list_tuple(mp_obj_t value, char typecod
 
 
 static mp_obj_t ndarray_make_new(const mp_obj_type_t *type_in, mp_int_t n_args, mp_int_t n_kw, const mp_obj_t *args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
     (void)type_in;
     mp_arg_check_num(n_args, n_kw, 1, 2, false);
 
@@ -499,6 +704,8 @@ uumpy_obj_ndarray_t *uumpy_array_from_value(const mp_obj_t value, char typecode)
 }
 
 static mp_obj_t uumpy_array(size_t n_args, const mp_obj_t *args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
     char typecode = UUMPY_DEFAULT_TYPE;
 
     if (n_args == 2) {
@@ -529,13 +736,14 @@ bool ndarray_compare_dimensions(uumpy_obj_ndarray_t *left_in, uumpy_obj_ndarray_
 
 // Returns true if the left array needed to be expanded
 // If the entries are different lengths we pad the _start_ to that the ends align.
-// If one dimension las length L>1 and the other has length 1 then reset to length L with stride 1
-bool ndarray_broadcast(uumpy_obj_ndarray_t *left_in, uumpy_obj_ndarray_t *right_in,
-                       uumpy_obj_ndarray_t **left_out, uumpy_obj_ndarray_t **right_out) {
+// If one dimension las length L>1 and the other has length 1 then reset to length L with stride 0
+// The broadcast views are written into the headers in bcast, so nothing is allocated.
+bool ndarray_broadcast_in_place(uumpy_obj_ndarray_t *left_in, uumpy_obj_ndarray_t *right_in,
+                                uumpy_broadcast *bcast) {
     mp_int_t output_dim_count = MAX(left_in->dim_count, right_in->dim_count);
     bool left_touched = (output_dim_count != left_in->dim_count);
-    uumpy_dim_info left_dim_info[UUMPY_MAX_DIMS];
-    uumpy_dim_info right_dim_info[UUMPY_MAX_DIMS];
+    uumpy_dim_info *left_dim_info = bcast->left_dim_info;
+    uumpy_dim_info *right_dim_info = bcast->right_dim_info;
 
     // DEBUG_printf("Broadcasting between %d-D array and %d-D array into %d-D array\n",
     //              left_in->dim_count, right_in->dim_count, output_dim_count);
@@ -585,18 +793,36 @@ bool ndarray_broadcast(uumpy_obj_ndarray_t *left_in, uumpy_obj_ndarray_t *right_
     }
 
 
+    // Fill in the view headers
+    bcast->left = *left_in;
+    bcast->left.simple = 0;
+    bcast->left.dim_count = output_dim_count;
+    bcast->left.dim_info = left_dim_info;
 
-    // Make the new views
-    *left_out = ndarray_new_view(left_in, left_in->base_offset,
-                                 output_dim_count, left_dim_info);
-    *right_out = ndarray_new_view(right_in, right_in->base_offset,
-                                 output_dim_count, right_dim_info);
+    bcast->right = *right_in;
+    bcast->right.simple = 0;
+    bcast->right.dim_count = output_dim_count;
+    bcast->right.dim_info = right_dim_info;
 
     // DEBUG_printf("Broadcast complete. Left%s touched\n", left_touched ? "" : " not");
 
     return left_touched;
 }
 
+// As above but making new views on the heap, for when they need to outlive the caller
+bool ndarray_broadcast(uumpy_obj_ndarray_t *left_in, uumpy_obj_ndarray_t *right_in,
+                       uumpy_obj_ndarray_t **left_out, uumpy_obj_ndarray_t **right_out) {
+    uumpy_broadcast bcast;
+    bool left_touched = ndarray_broadcast_in_place(left_in, right_in, &bcast);
+
+    *left_out = ndarray_new_view(left_in, left_in->base_offset,
+                                 bcast.left.dim_count, bcast.left_dim_info);
+    *right_out = ndarray_new_view(right_in, right_in->base_offset,
+                                  bcast.right.dim_count, bcast.right_dim_info);
+
+    return left_touched;
+}
+
 static mp_obj_t ndarray_unary_op(mp_unary_op_t op, mp_obj_t o_in) {
     uumpy_obj_ndarray_t *o = MP_OBJ_TO_PTR(o_in);
     char result_typecode = 0;
@@ -626,6 +852,9 @@ static mp_obj_t ndarray_unary_op(mp_unary_op_t op, mp_obj_t o_in) {
     }
 
     uumpy_obj_ndarray_t *result = ndarray_new_shaped_like(result_typecode, o, 0);
+    uumpy_obj_ndarray_t *ops[2] = {result, o};
+
+    UUMPY_GRAPH_RECORD(2, ops, &spec);
 
     if (!ufunc_apply_unary(result, o, &spec)) {
         return MP_OBJ_NULL;
@@ -638,6 +867,8 @@ static mp_obj_t ndarray_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t r
     uumpy_obj_ndarray_t *lhs;
     uumpy_obj_ndarray_t *rhs;
 
+    uumpy_scalar rhs_scalar;
+
     char result_typecode;
     bool in_place = false;
     bool reverse = false;
@@ -645,13 +876,13 @@ static mp_obj_t ndarray_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t r
     // DEBUG_printf("Binary op: %d, lhs=%p, rhs=%p\n", op, lhs_in, rhs_in);
 
     lhs = MP_OBJ_TO_PTR(lhs_in);
-    if (!mp_obj_is_type(rhs_in, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
-        // DEBUG_printf("Making new array from input %p\n", rhs_in);
-        rhs = uumpy_array_from_value(rhs_in, lhs->typecode);
-    } else {
-        // DEBUG_printf("Using existing rhs object\n");
-        rhs = MP_OBJ_TO_PTR(rhs_in);
+#if UUMPY_ENABLE_SPARSE
+    // Let sparse matrices handle the reversed operation
+    if (mp_obj_is_type(rhs_in, &uumpy_sparse_type_csr_matrix)) {
+        return MP_OBJ_NULL;
     }
+#endif
+    rhs = ndarray_operand_from_value(rhs_in, lhs->typecode, &rhs_scalar);
 
     // DEBUG_printf("Using views: lhs=%p, rhs=%p\n", lhs, rhs);
 
@@ -732,6 +963,7 @@ static mp_obj_t ndarray_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t r
 
     uumpy_obj_ndarray_t *lhs_view;
     uumpy_obj_ndarray_t *rhs_view;
+    uumpy_broadcast bcast;
 
     if (ndarray_compare_dimensions(lhs, rhs)) {
         lhs_view = lhs;
@@ -740,7 +972,9 @@ static mp_obj_t ndarray_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t r
         // DEBUG_printf("Dimensions not the same. Broadcasting\n");
 
         bool left_expand;
-        left_expand = ndarray_broadcast(lhs, rhs, &lhs_view, &rhs_view);
+        left_expand = ndarray_broadcast_in_place(lhs, rhs, &bcast);
+        lhs_view = &bcast.left;
+        rhs_view = &bcast.right;
         if (left_expand && in_place) {
             mp_raise_ValueError(MP_ERROR_TEXT("non-broadcastable output operand"));
         }
@@ -769,9 +1003,19 @@ static mp_obj_t ndarray_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t r
         result = lhs;
     }
 
+    uumpy_obj_ndarray_t *ops[3] = {result, lhs_view, rhs_view};
+    uumpy_iteration_views overlap_views;
+
+    UUMPY_GRAPH_RECORD(3, ops, &spec);
+
+    if (in_place) {
+        // The other operand might be another view on the same data
+        ufunc_resolve_overlap(3, ops, &overlap_views);
+    }
+
     // DEBUG_printf("Calling application function\n");
 
-    if (!ufunc_apply_binary(result, lhs_view, rhs_view, &spec)) {
+    if (!ufunc_apply_binary(ops[0], ops[1], ops[2], &spec)) {
         return MP_OBJ_NULL;
     } else {
         return ndarray_get_obj_or_0d(result);
@@ -903,6 +1147,7 @@ static mp_obj_t ndarray_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t val
 
     if (value == MP_OBJ_SENTINEL) {
         if (target_dim_offset == 0) {
+            UUMPY_GRAPH_UNRECORDABLE();
             return mp_binary_get_val_array(o->typecode, o->data, target_base_offset);
         } else {
             return MP_OBJ_FROM_PTR(ndarray_new_view(o, target_base_offset,
@@ -910,30 +1155,43 @@ static mp_obj_t ndarray_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t val
         }
     } else {
         if (target_dim_offset == 0) {
+            UUMPY_GRAPH_UNRECORDABLE();
             mp_binary_set_val_array(o->typecode, o->data, target_base_offset, value);
             return mp_const_none;
         } else {
-            uumpy_obj_ndarray_t *dest, *src;
-            dest = ndarray_new_view(o, target_base_offset, target_dim_offset, target_dim_info);
+            // The target view is only needed for the copy so keep it on the stack
+            uumpy_obj_ndarray_t target = *o;
+            uumpy_obj_ndarray_t *dest = &target, *src;
+            uumpy_scalar src_scalar;
 
-            if (!mp_obj_is_type(value, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
-                src = uumpy_array_from_value(value, o->typecode);
-            } else {
-                src = MP_OBJ_TO_PTR(value);
-            }
+            target.simple = 0;
+            target.dim_count = target_dim_offset;
+            target.base_offset = target_base_offset;
+            target.dim_info = target_dim_info;
+
+            src = ndarray_operand_from_value(value, o->typecode, &src_scalar);
+
+            uumpy_broadcast bcast;
 
             if (!ndarray_compare_dimensions(src, dest)) {
                 // Try broadcasting
-                if (ndarray_broadcast(dest, src, &dest, &src)) {
+                if (ndarray_broadcast_in_place(dest, src, &bcast)) {
                     mp_raise_ValueError(MP_ERROR_TEXT("value can not be broadcast into slice"));
                 }
+                dest = &bcast.left;
+                src = &bcast.right;
             }
             // Copy values
             uumpy_universal_spec copy_spec;
+            uumpy_obj_ndarray_t *ops[2] = {dest, src};
+            uumpy_iteration_views overlap_views;
 
-            ufunc_find_copy_spec(src, dest, NULL, &copy_spec);
+            UUMPY_GRAPH_RECORD(2, ops, NULL);
 
-            ufunc_apply_unary(dest, src, &copy_spec);
+            ufunc_resolve_overlap(2, ops, &overlap_views);
+            ufunc_find_copy_spec(ops[1], ops[0], NULL, &copy_spec);
+
+            ufunc_apply_unary(ops[0], ops[1], &copy_spec);
 
             return mp_const_none;
         }
@@ -1008,6 +1266,7 @@ static mp_obj_t ndarray_reshape(mp_obj_t self_in, mp_obj_t new_shape_obj) {
     uumpy_obj_ndarray_t *new_array = NULL;
 
     if (!o->simple) {
+        UUMPY_GRAPH_UNRECORDABLE();
         o = ndarray_new_from_ndarray(self_in, 0);
     }
 
@@ -1087,6 +1346,25 @@ static bool _uumpy_isclose_func_float(size_t depth,
     return true;
 }
 
+#if UUMPY_SINGLE_KERNELS
+static bool _uumpy_isclose_func_single(size_t depth,
+                                       uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                       uumpy_obj_ndarray_t *src1, mp_int_t src1_offset,
+                                       uumpy_obj_ndarray_t *src2, mp_int_t src2_offset,
+                                       struct _uumpy_universal_spec *spec) {
+    (void) depth;
+
+    float *src1_data = src1->data;
+    float *src2_data = src2->data;
+    unsigned char *dest_data = dest->data;
+
+    dest_data[dest_offset] = _uumpy_isclose_test(src1_data[src1_offset],
+                                                 src2_data[src2_offset],
+                                                 spec->context);
+    return true;
+}
+#endif
+
 static bool _uumpy_isclose_func_fallback(size_t depth,
                                           uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
                                           uumpy_obj_ndarray_t *src1, mp_int_t src1_offset,
@@ -1109,6 +1387,8 @@ static bool _uumpy_isclose_func_fallback(size_t depth,
 
 static mp_obj_t uumpy_isclose(mp_uint_t n_args, const mp_obj_t *pos_args,
                               mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
     enum {
         ARG_a,
         ARG_b,
@@ -1154,8 +1434,12 @@ static mp_obj_t uumpy_isclose(mp_uint_t n_args, const mp_obj_t *pos_args,
         close_spec.atol = mp_obj_get_float(args[ARG_atol].u_obj);
     }
 
+    uumpy_broadcast bcast;
+
     if (!ndarray_compare_dimensions(a, b)) {
-        ndarray_broadcast(a, b, &a, &b);
+        ndarray_broadcast_in_place(a, b, &bcast);
+        a = &bcast.left;
+        b = &bcast.right;
     }
 
     uumpy_obj_ndarray_t *result = ndarray_new_shaped_like('B', a, 0);
@@ -1166,8 +1450,13 @@ static mp_obj_t uumpy_isclose(mp_uint_t n_args, const mp_obj_t *pos_args,
 
     if (a->typecode == UUMPY_DEFAULT_TYPE && b->typecode == UUMPY_DEFAULT_TYPE) {
         spec.apply_fn.binary = _uumpy_isclose_func_float;
+    #if UUMPY_SINGLE_KERNELS
+    } else if (a->typecode == 'f' && b->typecode == 'f') {
+        spec.apply_fn.binary = _uumpy_isclose_func_single;
+    #endif
     } else {
         spec.apply_fn.binary = _uumpy_isclose_func_fallback;
+        spec.boxed = 1;
     }
 
     ufunc_apply_binary(result, a, b, &spec);
@@ -1176,6 +1465,297 @@ static mp_obj_t uumpy_isclose(mp_uint_t n_args, const mp_obj_t *pos_args,
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_isclose_obj, 1, uumpy_isclose);
 
+// where() and clip() take three inputs, so they use the n-ary iterator.
+// The fallback kernels find the operand types in the context.
+
+static bool _uumpy_where_func_float(mp_int_t count, void **data, const mp_int_t *strides,
+                                    struct _uumpy_universal_spec *spec) {
+    (void) spec;
+    mp_float_t *dest = data[0];
+    const unsigned char *cond = data[1];
+    const mp_float_t *x = data[2];
+    const mp_float_t *y = data[3];
+
+    for (mp_int_t i = count; i > 0; i--) {
+        *dest = *cond ? *x : *y;
+        dest += strides[0];
+        cond += strides[1];
+        x += strides[2];
+        y += strides[3];
+    }
+
+    return true;
+}
+
+#if UUMPY_SINGLE_KERNELS
+static bool _uumpy_where_func_single(mp_int_t count, void **data, const mp_int_t *strides,
+                                     struct _uumpy_universal_spec *spec) {
+    (void) spec;
+    float *dest = data[0];
+    const unsigned char *cond = data[1];
+    const float *x = data[2];
+    const float *y = data[3];
+
+    for (mp_int_t i = count; i > 0; i--) {
+        *dest = *cond ? *x : *y;
+        dest += strides[0];
+        cond += strides[1];
+        x += strides[2];
+        y += strides[3];
+    }
+
+    return true;
+}
+
+// Python floats don't widen float32 arrays, as in numpy
+static bool _uumpy_is_single_array(mp_obj_t o) {
+    return mp_obj_is_type(o, MP_OBJ_FROM_PTR(&uumpy_type_ndarray)) &&
+           ((uumpy_obj_ndarray_t *) MP_OBJ_TO_PTR(o))->typecode == 'f';
+}
+#endif
+
+static bool _uumpy_where_func_fallback(mp_int_t count, void **data, const mp_int_t *strides,
+                                       struct _uumpy_universal_spec *spec) {
+    uumpy_obj_ndarray_t **ops = spec->context;
+
+    for (mp_int_t i=0; i < count; i++) {
+        mp_obj_t cond = mp_binary_get_val_array(ops[1]->typecode, data[1], i * strides[1]);
+        mp_int_t k = mp_obj_is_true(cond) ? 2 : 3;
+        mp_obj_t value = mp_binary_get_val_array(ops[k]->typecode, data[k], i * strides[k]);
+        mp_binary_set_val_array(ops[0]->typecode, data[0], i * strides[0], value);
+    }
+
+    return true;
+}
+
+static mp_obj_t uumpy_where(mp_obj_t cond_in, mp_obj_t x_in, mp_obj_t y_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_obj_ndarray_t *ops[4];
+    uumpy_scalar scalars[3];
+
+    char value_typecode = UUMPY_DEFAULT_TYPE;
+    #if UUMPY_SINGLE_KERNELS
+    if (_uumpy_is_single_array(x_in) || _uumpy_is_single_array(y_in)) {
+        value_typecode = 'f';
+    }
+    #endif
+
+    ops[1] = ndarray_operand_from_value(cond_in, 'B', &scalars[0]);
+    ops[2] = ndarray_operand_from_value(x_in, value_typecode, &scalars[1]);
+    ops[3] = ndarray_operand_from_value(y_in, value_typecode, &scalars[2]);
+
+    char result_typecode = (ops[2]->typecode == ops[3]->typecode) ? ops[2]->typecode : UUMPY_DEFAULT_TYPE;
+    mp_int_t dims[UUMPY_MAX_DIMS];
+    mp_int_t dim_count = ufunc_broadcast_shape(3, ops + 1, dims);
+
+    ops[0] = ndarray_new(result_typecode, dim_count, dims);
+
+    uumpy_universal_spec spec = {
+        .layers = 0,
+        .context = ops,
+    };
+
+    if (ops[1]->typecode == 'B' &&
+        ops[0]->typecode == UUMPY_DEFAULT_TYPE &&
+        ops[2]->typecode == UUMPY_DEFAULT_TYPE &&
+        ops[3]->typecode == UUMPY_DEFAULT_TYPE) {
+        spec.apply_fn.nary = _uumpy_where_func_float;
+    #if UUMPY_SINGLE_KERNELS
+    } else if (ops[1]->typecode == 'B' &&
+               ops[0]->typecode == 'f' &&
+               ops[2]->typecode == 'f' &&
+               ops[3]->typecode == 'f') {
+        spec.apply_fn.nary = _uumpy_where_func_single;
+    #endif
+    } else {
+        spec.apply_fn.nary = _uumpy_where_func_fallback;
+        spec.boxed = 1;
+    }
+
+    ufunc_apply_nary(4, ops, &spec);
+
+    return ndarray_get_obj_or_0d(ops[0]);
+}
+MP_DEFINE_CONST_FUN_OBJ_3(uumpy_where_obj, uumpy_where);
+
+static bool _uumpy_clip_func_float(mp_int_t count, void **data, const mp_int_t *strides,
+                                   struct _uumpy_universal_spec *spec) {
+    (void) spec;
+    mp_float_t *dest = data[0];
+    const mp_float_t *a = data[1];
+    const mp_float_t *lo = data[2];
+    const mp_float_t *hi = data[3];
+
+    for (mp_int_t i = count; i > 0; i--) {
+        mp_float_t v = *a;
+        if (v < *lo) {
+            v = *lo;
+        }
+        if (v > *hi) {
+            v = *hi;
+        }
+        *dest = v;
+        dest += strides[0];
+        a += strides[1];
+        lo += strides[2];
+        hi += strides[3];
+    }
+
+    return true;
+}
+
+#if UUMPY_SINGLE_KERNELS
+static bool _uumpy_clip_func_single(mp_int_t count, void **data, const mp_int_t *strides,
+                                    struct _uumpy_universal_spec *spec) {
+    (void) spec;
+    float *dest = data[0];
+    const float *a = data[1];
+    const float *lo = data[2];
+    const float *hi = data[3];
+
+    for (mp_int_t i = count; i > 0; i--) {
+        float v = *a;
+        if (v < *lo) {
+            v = *lo;
+        }
+        if (v > *hi) {
+            v = *hi;
+        }
+        *dest = v;
+        dest += strides[0];
+        a += strides[1];
+        lo += strides[2];
+        hi += strides[3];
+    }
+
+    return true;
+}
+#endif
+
+// A missing limit doesn't limit anything. Infinity needs a float type, so
+// this is the default type unless the array is float32.
+static uumpy_obj_ndarray_t *_uumpy_clip_no_limit(uumpy_scalar *scalar, char typecode, mp_float_t limit) {
+    uumpy_obj_ndarray_t *o;
+
+    #if UUMPY_SINGLE_KERNELS
+    if (typecode == 'f') {
+        o = ndarray_init_scalar(scalar, 'f');
+        *(float *) o->data = (float) limit;
+        return o;
+    }
+    #else
+    (void) typecode;
+    #endif
+
+    o = ndarray_init_scalar(scalar, UUMPY_DEFAULT_TYPE);
+    *(mp_float_t *) o->data = limit;
+    return o;
+}
+
+static bool _uumpy_clip_func_fallback(mp_int_t count, void **data, const mp_int_t *strides,
+                                      struct _uumpy_universal_spec *spec) {
+    uumpy_obj_ndarray_t **ops = spec->context;
+
+    for (mp_int_t i=0; i < count; i++) {
+        mp_obj_t value = mp_binary_get_val_array(ops[1]->typecode, data[1], i * strides[1]);
+        mp_obj_t lo = mp_binary_get_val_array(ops[2]->typecode, data[2], i * strides[2]);
+        mp_obj_t hi = mp_binary_get_val_array(ops[3]->typecode, data[3], i * strides[3]);
+
+        if (mp_binary_op(MP_BINARY_OP_LESS, value, lo) == mp_const_true) {
+            value = lo;
+        }
+        if (mp_binary_op(MP_BINARY_OP_MORE, value, hi) == mp_const_true) {
+            value = hi;
+        }
+        mp_binary_set_val_array(ops[0]->typecode, data[0], i * strides[0], value);
+    }
+
+    return true;
+}
+
+static mp_obj_t uumpy_clip(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_a,
+        ARG_a_min,
+        ARG_a_max,
+        ARG_out,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_a,     MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_a_min, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_a_max, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_out,   MP_ARG_OBJ,                   {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_obj_ndarray_t *ops[4];
+    uumpy_scalar scalars[3];
+
+    if (args[ARG_a_min].u_obj == mp_const_none && args[ARG_a_max].u_obj == mp_const_none) {
+        mp_raise_ValueError(MP_ERROR_TEXT("one of a_min and a_max must be given"));
+    }
+
+    ops[1] = ndarray_operand_from_value(args[ARG_a].u_obj, UUMPY_DEFAULT_TYPE, &scalars[0]);
+
+    if (args[ARG_a_min].u_obj == mp_const_none) {
+        ops[2] = _uumpy_clip_no_limit(&scalars[1], ops[1]->typecode, -INFINITY);
+    } else {
+        ops[2] = ndarray_operand_from_value(args[ARG_a_min].u_obj, ops[1]->typecode, &scalars[1]);
+    }
+    if (args[ARG_a_max].u_obj == mp_const_none) {
+        ops[3] = _uumpy_clip_no_limit(&scalars[2], ops[1]->typecode, INFINITY);
+    } else {
+        ops[3] = ndarray_operand_from_value(args[ARG_a_max].u_obj, ops[1]->typecode, &scalars[2]);
+    }
+
+    if (args[ARG_out].u_obj == mp_const_none) {
+        mp_int_t dims[UUMPY_MAX_DIMS];
+        mp_int_t dim_count = ufunc_broadcast_shape(3, ops + 1, dims);
+        ops[0] = ndarray_new(ops[1]->typecode, dim_count, dims);
+    } else {
+        if (!mp_obj_is_type(args[ARG_out].u_obj, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+            mp_raise_TypeError(MP_ERROR_TEXT("out must be an array"));
+        }
+        ops[0] = MP_OBJ_TO_PTR(args[ARG_out].u_obj);
+    }
+
+    uumpy_obj_ndarray_t *result = ops[0];
+    uumpy_iteration_views overlap_views;
+
+    ufunc_resolve_overlap(4, ops, &overlap_views);
+
+    uumpy_universal_spec spec = {
+        .layers = 0,
+        .context = ops,
+    };
+
+    if (ops[0]->typecode == UUMPY_DEFAULT_TYPE &&
+        ops[1]->typecode == UUMPY_DEFAULT_TYPE &&
+        ops[2]->typecode == UUMPY_DEFAULT_TYPE &&
+        ops[3]->typecode == UUMPY_DEFAULT_TYPE) {
+        spec.apply_fn.nary = _uumpy_clip_func_float;
+    #if UUMPY_SINGLE_KERNELS
+    } else if (ops[0]->typecode == 'f' &&
+               ops[1]->typecode == 'f' &&
+               ops[2]->typecode == 'f' &&
+               ops[3]->typecode == 'f') {
+        spec.apply_fn.nary = _uumpy_clip_func_single;
+    #endif
+    } else {
+        spec.apply_fn.nary = _uumpy_clip_func_fallback;
+        spec.boxed = 1;
+    }
+
+    ufunc_apply_nary(4, ops, &spec);
+
+    return ndarray_get_obj_or_0d(result);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_clip_obj, 3, uumpy_clip);
+
 static const mp_rom_map_elem_t ndarray_locals_dict_table[] = {
     //    { MP_ROM_QSTR(MP_QSTR_T), MP_ROM_PTR(&ndarray_T_property_obj) },
     //    { MP_ROM_QSTR(MP_QSTR_shape), MP_ROM_PTR(&array_shape_property_obj) },
@@ -1223,6 +1803,197 @@ MP_DEFINE_CONST_OBJ_TYPE(
         attr, ndarray_attr
 );
 
+#if UUMPY_ENABLE_NOALLOC
+
+// uumpy.noalloc() returns a context manager. The blocks can be nested, so
+// we just count how deep we are.
+mp_uint_t uumpy_noalloc_depth = 0;
+
+void uumpy_noalloc_raise(void) {
+    mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("uumpy allocation in noalloc block"));
+}
+
+mp_obj_t uumpy_noalloc_check_boxed(mp_obj_t value) {
+    if (uumpy_noalloc_depth && mp_obj_is_obj(value) &&
+        (mp_obj_is_float(value) || mp_obj_is_type(value, &mp_type_int))) {
+        uumpy_noalloc_raise();
+    }
+    return value;
+}
+
+static const mp_obj_base_t uumpy_noalloc_singleton;
+
+static mp_obj_t uumpy_noalloc_make_new(const mp_obj_type_t *type_in, size_t n_args,
+                                       size_t n_kw, const mp_obj_t *args) {
+    (void) type_in;
+    (void) args;
+    mp_arg_check_num(n_args, n_kw, 0, 0, false);
+
+    // There is no state, so there is no need to allocate anything
+    return MP_OBJ_FROM_PTR(&uumpy_noalloc_singleton);
+}
+
+static mp_obj_t uumpy_noalloc_enter(mp_obj_t self_in) {
+    uumpy_noalloc_depth++;
+    return self_in;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_noalloc_enter_obj, uumpy_noalloc_enter);
+
+static mp_obj_t uumpy_noalloc_exit(size_t n_args, const mp_obj_t *args) {
+    (void) n_args;
+    (void) args;
+    if (uumpy_noalloc_depth > 0) {
+        uumpy_noalloc_depth--;
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(uumpy_noalloc_exit_obj, 4, 4, uumpy_noalloc_exit);
+
+static const mp_rom_map_elem_t uumpy_noalloc_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&uumpy_noalloc_enter_obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&uumpy_noalloc_exit_obj) },
+};
+static MP_DEFINE_CONST_DICT(uumpy_noalloc_locals_dict, uumpy_noalloc_locals_dict_table);
+
+static MP_DEFINE_CONST_OBJ_TYPE(
+        uumpy_type_noalloc,
+        MP_QSTR_noalloc,
+        MP_TYPE_FLAG_NONE,
+        make_new, uumpy_noalloc_make_new,
+        locals_dict, &uumpy_noalloc_locals_dict
+);
+
+static const mp_obj_base_t uumpy_noalloc_singleton = { &uumpy_type_noalloc };
+
+#endif // UUMPY_ENABLE_NOALLOC
+
+#if UUMPY_POOL_SIZE
+
+// uumpy.release(a) says that a is no longer needed, so its memory can go to
+// the next array of the same size. Neither a nor any view of it may be
+// used afterwards.
+static mp_obj_t uumpy_release(mp_obj_t array_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    if (!mp_obj_is_type(array_in, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+        mp_raise_TypeError(MP_ERROR_TEXT("can only release arrays"));
+    }
+
+    if (!ndarray_pool_put(MP_OBJ_TO_PTR(array_in))) {
+        mp_raise_ValueError(MP_ERROR_TEXT("array does not own its data"));
+    }
+
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_release_obj, uumpy_release);
+
+// with uumpy.scope() as s: releases every array made inside the block when
+// the block exits, even ones that still have views, so no view of them may
+// be used afterwards either. s.keep(a) hands a, or the array a is a view
+// of, to the enclosing scope, if any, and returns a, so that results can
+// outlive the block. A scope can't be entered while it is already active.
+// Making a scope allocates, as does its list of arrays when it grows, so
+// only a scope made once outside uumpy.noalloc() and reused, once its list
+// is big enough, runs without allocating.
+static mp_obj_t uumpy_scope_make_new(const mp_obj_type_t *type_in, size_t n_args,
+                                     size_t n_kw, const mp_obj_t *args) {
+    (void) args;
+    mp_arg_check_num(n_args, n_kw, 0, 0, false);
+
+    uumpy_obj_scope_t *o = uumpy_new_obj(uumpy_obj_scope_t);
+    o->base.type = type_in;
+    o->parent = NULL;
+    o->count = 0;
+    o->alloc = 0;
+    o->arrays = NULL;
+
+    return MP_OBJ_FROM_PTR(o);
+}
+
+static mp_obj_t uumpy_scope_enter(mp_obj_t self_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_obj_scope_t *self = MP_OBJ_TO_PTR(self_in);
+
+    // Entering it again would lose the enclosing scope
+    for (uumpy_obj_scope_t *s = uumpy_scope_current; s != NULL; s = s->parent) {
+        if (s == self) {
+            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("scope is already active"));
+        }
+    }
+
+    self->parent = uumpy_scope_current;
+    self->count = 0;
+    uumpy_scope_current = self;
+
+    return self_in;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_scope_enter_obj, uumpy_scope_enter);
+
+static mp_obj_t uumpy_scope_exit(size_t n_args, const mp_obj_t *args) {
+    (void) n_args;
+    uumpy_obj_scope_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    uumpy_scope_current = self->parent;
+    self->parent = NULL;
+
+    for (size_t i=0; i < self->count; i++) {
+        ndarray_pool_put(self->arrays[i]);
+        self->arrays[i] = NULL;
+    }
+    self->count = 0;
+
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(uumpy_scope_exit_obj, 4, 4, uumpy_scope_exit);
+
+static mp_obj_t uumpy_scope_keep(mp_obj_t self_in, mp_obj_t array_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_obj_scope_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if (!mp_obj_is_type(array_in, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+        mp_raise_TypeError(MP_ERROR_TEXT("can only keep arrays"));
+    }
+
+    // Views share the data pointer of the array that owns the buffer, so
+    // keeping a view, such as the result of .T or reshape(), keeps its
+    // owner. A recycled header can be on the list more than once.
+    void *data = ((uumpy_obj_ndarray_t *) MP_OBJ_TO_PTR(array_in))->data;
+    uumpy_obj_ndarray_t *owner = NULL;
+
+    for (size_t i=self->count; i > 0; i--) {
+        if (self->arrays[i-1]->data == data) {
+            owner = self->arrays[i-1];
+            self->arrays[i-1] = self->arrays[--self->count];
+        }
+    }
+
+    if (owner && self->parent) {
+        uumpy_scope_record(self->parent, owner);
+    }
+
+    return array_in;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(uumpy_scope_keep_obj, uumpy_scope_keep);
+
+static const mp_rom_map_elem_t uumpy_scope_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&uumpy_scope_enter_obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&uumpy_scope_exit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_keep), MP_ROM_PTR(&uumpy_scope_keep_obj) },
+};
+static MP_DEFINE_CONST_DICT(uumpy_scope_locals_dict, uumpy_scope_locals_dict_table);
+
+static MP_DEFINE_CONST_OBJ_TYPE(
+        uumpy_type_scope,
+        MP_QSTR_scope,
+        MP_TYPE_FLAG_NONE,
+        make_new, uumpy_scope_make_new,
+        locals_dict, &uumpy_scope_locals_dict
+);
+
+#endif // UUMPY_POOL_SIZE
+
 // Define all properties of the uumpy module.
 // Table entries are key/value pairs of the attribute name (a string)
 // and the MicroPython object reference.
@@ -1258,10 +2029,31 @@ static const mp_rom_map_elem_t uumpy_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_linalg), MP_ROM_PTR(&uumpy_linalg_module) },
 #endif
 
+#if UUMPY_ENABLE_SIGNAL
+    { MP_ROM_QSTR(MP_QSTR_signal), MP_ROM_PTR(&uumpy_signal_module) },
+#endif
+
+#if UUMPY_ENABLE_SPARSE
+    { MP_ROM_QSTR(MP_QSTR_sparse), MP_ROM_PTR(&uumpy_sparse_module) },
+#endif
+
     { MP_ROM_QSTR(MP_QSTR_log), MP_ROM_PTR(&uumpy_math_log_obj) },
     { MP_ROM_QSTR(MP_QSTR_exp), MP_ROM_PTR(&uumpy_math_exp_obj) },
+    { MP_ROM_QSTR(MP_QSTR_prepare), MP_ROM_PTR(&uumpy_math_prepare_obj) },
+#if UUMPY_ENABLE_GRAPH
+    { MP_ROM_QSTR(MP_QSTR_Graph), MP_ROM_PTR(&uumpy_type_Graph) },
+#endif
+#if UUMPY_ENABLE_NOALLOC
+    { MP_ROM_QSTR(MP_QSTR_noalloc), MP_ROM_PTR(&uumpy_type_noalloc) },
+#endif
+#if UUMPY_POOL_SIZE
+    { MP_ROM_QSTR(MP_QSTR_release), MP_ROM_PTR(&uumpy_release_obj) },
+    { MP_ROM_QSTR(MP_QSTR_scope), MP_ROM_PTR(&uumpy_type_scope) },
+#endif
 
     { MP_ROM_QSTR(MP_QSTR_isclose), MP_ROM_PTR(&uumpy_isclose_obj) },
+    { MP_ROM_QSTR(MP_QSTR_where), MP_ROM_PTR(&uumpy_where_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clip), MP_ROM_PTR(&uumpy_clip_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_LinAlgError), MP_ROM_PTR(&uumpy_linalg_type_LinAlgError) },
 
@@ -45,9 +45,38 @@
 #define UUMPY_DTYPE_FLOAT (8)
 #define UUMPY_DTYPE_COMPLEX (10)
 
-// We limit ourselves to 8 dimensions in n-D arrays. Having a limit
-// allows us to have dim lists on the stack.
-#define UUMPY_MAX_DIMS 8
+// We limit the number of dimensions in n-D arrays, as set in uumpy_config.h.
+// Having a limit allows us to have dim lists on the stack. Matrices need
+// at least two and the transpose code uses a bit mask of dimensions.
+#if UUMPY_MAX_DIMS < 2 || UUMPY_MAX_DIMS > 16
+#error UUMPY_MAX_DIMS must be between 2 and 16
+#endif
+
+#if UUMPY_DATA_ALIGNMENT < 1 || (UUMPY_DATA_ALIGNMENT & (UUMPY_DATA_ALIGNMENT - 1)) != 0
+#error UUMPY_DATA_ALIGNMENT must be a power of two
+#endif
+
+// sparse.cg and sparse.gmres are the linalg solvers
+#if UUMPY_ENABLE_SPARSE && !UUMPY_ENABLE_LINALG
+#error UUMPY_ENABLE_SPARSE requires UUMPY_ENABLE_LINALG
+#endif
+
+// Over-aligned data can start part way into its GC block, and the GC only
+// recognises pointers to the start of a block, so arrays then keep a
+// pointer to the block as well.
+#define UUMPY_DATA_OVERALIGNED (UUMPY_DATA_ALIGNMENT > 16)
+
+#define UUMPY_IS_ALIGNED(ptr) ((((uintptr_t) (ptr)) & (UUMPY_DATA_ALIGNMENT - 1)) == 0)
+
+// On single precision builds float32 is the default type and already has
+// the float kernels.
+#define UUMPY_SINGLE_KERNELS (UUMPY_SPEEDUP_SINGLE && UUMPY_DEFAULT_TYPE == 'd')
+
+#if defined(__GNUC__)
+#define UUMPY_ASSUME_ALIGNED(ptr) __builtin_assume_aligned((ptr), UUMPY_DATA_ALIGNMENT)
+#else
+#define UUMPY_ASSUME_ALIGNED(ptr) (ptr)
+#endif
 
 // Each dimension of an n-D array has a length and stride
 typedef struct _uumpy_dim_info {
@@ -65,17 +94,70 @@ typedef struct _uumpy_obj_ndarray_t {
     mp_int_t base_offset;
     void *data;
     uumpy_dim_info *dim_info;
+#if UUMPY_DATA_OVERALIGNED
+    void *alloc; // The GC block holding the data
+#endif
 } uumpy_obj_ndarray_t;
 
 // This is the type definition
 extern const mp_obj_type_t uumpy_type_ndarray;
 
+// Two operands broadcast to a common shape. The array headers live in the
+// structure, normally on the caller's stack, and share data with the
+// original arrays, so broadcasting allocates nothing. They must not
+// escape from the function that owns the structure.
+typedef struct _uumpy_broadcast {
+    uumpy_obj_ndarray_t left;
+    uumpy_obj_ndarray_t right;
+    uumpy_dim_info left_dim_info[UUMPY_MAX_DIMS];
+    uumpy_dim_info right_dim_info[UUMPY_MAX_DIMS];
+} uumpy_broadcast;
+
+// A 0-d array holding a scalar operand, with room for any element type.
+// Like the broadcast headers it normally lives on the caller's stack and
+// must not escape.
+typedef struct _uumpy_scalar {
+    uumpy_obj_ndarray_t array;
+    union {
+        mp_obj_t obj;
+        double d;
+        long long q;
+    } value;
+} uumpy_scalar;
+
+// Inside a uumpy.noalloc() block every allocation that uumpy makes raises
+// MemoryError straight away, so code that runs cleanly in one is known not
+// to touch the heap. All allocations in the module go through these macros.
+//
+// Numbers that uumpy returns, such as full reductions and determinants,
+// are boxed on the heap unless they fit in the object word, so those are
+// checked as they are returned by wrapping them in UUMPY_BOXED_RESULT().
+#if UUMPY_ENABLE_NOALLOC
+extern mp_uint_t uumpy_noalloc_depth;
+NORETURN void uumpy_noalloc_raise(void);
+mp_obj_t uumpy_noalloc_check_boxed(mp_obj_t value);
+#define UUMPY_CHECK_ALLOC() (uumpy_noalloc_depth ? uumpy_noalloc_raise() : (void) 0)
+#define UUMPY_BOXED_RESULT(value) uumpy_noalloc_check_boxed(value)
+#else
+#define UUMPY_CHECK_ALLOC() ((void) 0)
+#define UUMPY_BOXED_RESULT(value) (value)
+#endif
+
+#define uumpy_new(type, num) (UUMPY_CHECK_ALLOC(), m_new(type, num))
+#define uumpy_new_obj(type) (UUMPY_CHECK_ALLOC(), m_new_obj(type))
+#define uumpy_renew(type, ptr, old_num, new_num) (UUMPY_CHECK_ALLOC(), m_renew(type, ptr, old_num, new_num))
+
+// Ports call this on a soft reset, see moduumpy.c
+void uumpy_soft_reset(void);
+
 bool uumpy_util_get_list_tuple(mp_obj_t value, mp_int_t *len, mp_obj_t **items);
 
 extern uumpy_obj_ndarray_t *uumpy_array_from_value(const mp_obj_t value, char typecode);
 extern uumpy_obj_ndarray_t *ndarray_new(char typecode, mp_int_t dim_count, mp_int_t *dims);
 extern bool ndarray_compare_dimensions(uumpy_obj_ndarray_t *left_in, uumpy_obj_ndarray_t *right_in);
 extern bool ndarray_compare_dimensions_counted(uumpy_obj_ndarray_t *left_in, uumpy_obj_ndarray_t *right_in, mp_int_t count);
+extern bool ndarray_broadcast_in_place(uumpy_obj_ndarray_t *left_in, uumpy_obj_ndarray_t *right_in,
+                                       uumpy_broadcast *bcast);
 extern bool ndarray_broadcast(uumpy_obj_ndarray_t *left_in, uumpy_obj_ndarray_t *right_in,
                               uumpy_obj_ndarray_t **left_out, uumpy_obj_ndarray_t **right_out);
 
@@ -83,5 +165,7 @@ uumpy_obj_ndarray_t *ndarray_new_from_ndarray(mp_obj_t value_in, char typecode);
 uumpy_obj_ndarray_t *ndarray_new_view(uumpy_obj_ndarray_t *source, mp_int_t new_base,
                                       mp_int_t new_dim_count, uumpy_dim_info *new_dims);
 uumpy_obj_ndarray_t *ndarray_new_shaped_like(char typecode, uumpy_obj_ndarray_t *other, mp_int_t trim_dims);
+uumpy_obj_ndarray_t *ndarray_init_scalar(uumpy_scalar *scalar, char typecode);
+uumpy_obj_ndarray_t *ndarray_operand_from_value(mp_obj_t value, char typecode, uumpy_scalar *scalar);
 
 #endif // UUMPY_INCLUDED_MODUUMPY_H
@@ -31,6 +31,7 @@
 
 #include "moduumpy.h"
 #include "ufunc.h"
+#include "graph.h"
 
 #define UUMPY_REDUCTION_FLAG_BOOL_OUT (0x100) // Result is boolean no matter what the input is
 #define UUMPY_REDUCTION_FLAG_INT_OUT (0x200) // Result is integer no matter what the input is
@@ -52,6 +53,8 @@
 
 #define UUMP_REDUCTION_FASTPATH_NONE (0)
 #define UUMP_REDUCTION_FASTPATH_FLOAT (1)
+#define UUMP_REDUCTION_FASTPATH_SINGLE (2)
+#define UUMP_REDUCTION_FASTPATH_INT64 (3)
 
 
 #define UUMPY_REDUCTION_FUN(name, operation) \
@@ -142,6 +145,10 @@ static mp_obj_t uumpy_reduction_generic(uumpy_obj_ndarray_t *src, uumpy_obj_ndar
     // Return the result
 
     mp_int_t reduce_layers;
+    // Reordering the axes uses a view that lives on the stack
+    uumpy_obj_ndarray_t reordered;
+    uumpy_dim_info new_dim_info[UUMPY_MAX_DIMS];
+    bool dest_given = (dest != NULL);
     
     if (axis == mp_const_none) {
         // Reduce over all layers
@@ -193,8 +200,6 @@ static mp_obj_t uumpy_reduction_generic(uumpy_obj_ndarray_t *src, uumpy_obj_ndar
 
         if (!only_trailing) {
             // Need to create a new view with the reduction dimensions at the end
-            uumpy_dim_info new_dim_info[UUMPY_MAX_DIMS];
-
             mp_int_t used = 0;
             for (mp_int_t i=0; i < src->dim_count; i++) {
                 if ((axis_mask & (1 << i)) == 0) {
@@ -208,7 +213,10 @@ static mp_obj_t uumpy_reduction_generic(uumpy_obj_ndarray_t *src, uumpy_obj_ndar
                 used++;
             }
 
-            src = ndarray_new_view(src, src->base_offset, src->dim_count, new_dim_info);
+            reordered = *src;
+            reordered.simple = 0;
+            reordered.dim_info = new_dim_info;
+            src = &reordered;
         }
     } else {
         goto axis_type_error;
@@ -222,7 +230,7 @@ static mp_obj_t uumpy_reduction_generic(uumpy_obj_ndarray_t *src, uumpy_obj_ndar
     // Most of the time we don't need much context so we grab some stack
     byte context[16];
     if (spec->state_size > sizeof(context)) {
-        ufn_spec.context = m_new(byte, spec->state_size);
+        ufn_spec.context = uumpy_new(byte, spec->state_size);
     } else {
         ufn_spec.context = context;
     }
@@ -241,8 +249,9 @@ static mp_obj_t uumpy_reduction_generic(uumpy_obj_ndarray_t *src, uumpy_obj_ndar
 
     ufunc_apply_unary(dest, src, &ufn_spec);
 
-    if (dest->dim_count == 0) {
-        return mp_binary_get_val_array(dest->typecode, dest->data, dest->base_offset);
+    // Full reductions give a number unless the caller supplied the output
+    if (dest->dim_count == 0 && !dest_given) {
+        return UUMPY_BOXED_RESULT(mp_binary_get_val_array(dest->typecode, dest->data, dest->base_offset));
     } else {
         return MP_OBJ_FROM_PTR(dest);
     }
@@ -352,6 +361,16 @@ static void uumpy_reduction_finish_store_float(uumpy_obj_ndarray_t *dest, mp_int
     ((mp_float_t *) dest->data)[dest_offset] = *((mp_float_t *) state_ptr); 
 }
 
+#if UUMPY_SINGLE_KERNELS
+static void uumpy_reduction_finish_store_single(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                                struct _uumpy_universal_spec *spec, void *state_ptr, int count) {
+    
+    (void) spec;
+    
+    ((float *) dest->data)[dest_offset] = (float) *((mp_float_t *) state_ptr);
+}
+#endif
+
 static void uumpy_reduction_finish_store_int(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
                                              struct _uumpy_universal_spec *spec, void *state_ptr, int count) {
     
@@ -432,6 +451,180 @@ static void uumpy_reduction_prod_float_op(uumpy_obj_ndarray_t *dest, mp_int_t de
     *state_float_ptr *= src_data[src_offset];
 }
 
+#if UUMPY_SINGLE_KERNELS
+// Float32 sources on double precision builds. The running value is kept as
+// a double so that long sums don't lose precision, and only the result is
+// narrowed.
+
+static void uumpy_reduction_max_single_op(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                          uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                          struct _uumpy_universal_spec *spec,
+                                          void *state_ptr, bool is_first) {
+    mp_float_t *state_float_ptr = (mp_float_t *) state_ptr;
+    float *src_data = (float *) src->data;
+
+    if ((src_data[src_offset] > *state_float_ptr) || is_first) {
+        *state_float_ptr = src_data[src_offset];
+    }
+}
+
+static void uumpy_reduction_min_single_op(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                          uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                          struct _uumpy_universal_spec *spec,
+                                          void *state_ptr, bool is_first) {
+    mp_float_t *state_float_ptr = (mp_float_t *) state_ptr;
+    float *src_data = (float *) src->data;
+
+    if ((src_data[src_offset] < *state_float_ptr) || is_first) {
+        *state_float_ptr = src_data[src_offset];
+    }
+}
+
+static void uumpy_reduction_sum_single_op(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                          uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                          struct _uumpy_universal_spec *spec,
+                                          void *state_ptr, bool is_first) {
+    mp_float_t *state_float_ptr = (mp_float_t *) state_ptr;
+    float *src_data = (float *) src->data;
+
+    *state_float_ptr += src_data[src_offset];
+}
+
+static void uumpy_reduction_prod_single_op(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                           uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                           struct _uumpy_universal_spec *spec,
+                                           void *state_ptr, bool is_first) {
+    mp_float_t *state_float_ptr = (mp_float_t *) state_ptr;
+    float *src_data = (float *) src->data;
+
+    *state_float_ptr *= src_data[src_offset];
+}
+
+static void uumpy_reduction_finish_average_single(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                                  struct _uumpy_universal_spec *spec, void *state_ptr, int count) {
+    
+    ((float *) dest->data)[dest_offset] = (float) (*((mp_float_t *) state_ptr) / count);
+}
+#endif
+
+#if UUMPY_SPEEDUP_INT64
+// 64-bit integer sources. Sums and products wrap as they do in numpy, so
+// the same code serves 'q' and 'Q'; only the comparisons differ.
+
+static void uumpy_reduction_init_zero_int64(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                            uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                            struct _uumpy_universal_spec *spec, void *state_ptr) {
+    (void) dest;
+    (void) dest_offset;
+    (void) src;
+    (void) src_offset;
+    (void) spec;
+
+    *((uint64_t *) state_ptr) = 0;
+}
+
+static void uumpy_reduction_init_one_int64(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                           uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                           struct _uumpy_universal_spec *spec, void *state_ptr) {
+    (void) dest;
+    (void) dest_offset;
+    (void) src;
+    (void) src_offset;
+    (void) spec;
+
+    *((uint64_t *) state_ptr) = 1;
+}
+
+static void uumpy_reduction_max_int64_op(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                         uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                         struct _uumpy_universal_spec *spec,
+                                         void *state_ptr, bool is_first) {
+    int64_t *state_int_ptr = (int64_t *) state_ptr;
+    int64_t *src_data = (int64_t *) src->data;
+
+    if ((src_data[src_offset] > *state_int_ptr) || is_first) {
+        *state_int_ptr = src_data[src_offset];
+    }
+}
+
+static void uumpy_reduction_min_int64_op(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                         uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                         struct _uumpy_universal_spec *spec,
+                                         void *state_ptr, bool is_first) {
+    int64_t *state_int_ptr = (int64_t *) state_ptr;
+    int64_t *src_data = (int64_t *) src->data;
+
+    if ((src_data[src_offset] < *state_int_ptr) || is_first) {
+        *state_int_ptr = src_data[src_offset];
+    }
+}
+
+static void uumpy_reduction_max_uint64_op(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                          uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                          struct _uumpy_universal_spec *spec,
+                                          void *state_ptr, bool is_first) {
+    uint64_t *state_int_ptr = (uint64_t *) state_ptr;
+    uint64_t *src_data = (uint64_t *) src->data;
+
+    if ((src_data[src_offset] > *state_int_ptr) || is_first) {
+        *state_int_ptr = src_data[src_offset];
+    }
+}
+
+static void uumpy_reduction_min_uint64_op(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                          uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                          struct _uumpy_universal_spec *spec,
+                                          void *state_ptr, bool is_first) {
+    uint64_t *state_int_ptr = (uint64_t *) state_ptr;
+    uint64_t *src_data = (uint64_t *) src->data;
+
+    if ((src_data[src_offset] < *state_int_ptr) || is_first) {
+        *state_int_ptr = src_data[src_offset];
+    }
+}
+
+static void uumpy_reduction_sum_int64_op(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                         uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                         struct _uumpy_universal_spec *spec,
+                                         void *state_ptr, bool is_first) {
+    uint64_t *state_int_ptr = (uint64_t *) state_ptr;
+    uint64_t *src_data = (uint64_t *) src->data;
+
+    *state_int_ptr += src_data[src_offset];
+}
+
+static void uumpy_reduction_prod_int64_op(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                          uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                          struct _uumpy_universal_spec *spec,
+                                          void *state_ptr, bool is_first) {
+    uint64_t *state_int_ptr = (uint64_t *) state_ptr;
+    uint64_t *src_data = (uint64_t *) src->data;
+
+    *state_int_ptr *= src_data[src_offset];
+}
+
+static void uumpy_reduction_finish_store_int64(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                               struct _uumpy_universal_spec *spec, void *state_ptr, int count) {
+    
+    (void) spec;
+    
+    ((uint64_t *) dest->data)[dest_offset] = *((uint64_t *) state_ptr);
+}
+
+// The average of integers is a float, as in numpy
+static void uumpy_reduction_finish_average_int64(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                                 struct _uumpy_universal_spec *spec, void *state_ptr, int count) {
+    
+    ((mp_float_t *) dest->data)[dest_offset] = (mp_float_t) *((int64_t *) state_ptr) / count;
+}
+
+static void uumpy_reduction_finish_average_uint64(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                                  struct _uumpy_universal_spec *spec, void *state_ptr, int count) {
+    
+    ((mp_float_t *) dest->data)[dest_offset] = (mp_float_t) *((uint64_t *) state_ptr) / count;
+}
+#endif
+
 static bool uumpy_reduction_find_unary_spec(unsigned int op_code,
                                             uumpy_obj_ndarray_t *src,
                                             uumpy_obj_ndarray_t *dest,
@@ -445,6 +638,11 @@ static bool uumpy_reduction_find_unary_spec(unsigned int op_code,
     } else if (op_code & UUMPY_REDUCTION_FLAG_FLOAT_COMPLEX_OUT) {
         // NOTE: This will need to be updated once we support complex numbers
         result_typecode = UUMPY_DEFAULT_TYPE;
+    #if UUMPY_SPEEDUP_INT64
+    } else if (op_code == UUMPY_REDUCTION_OP_AVERAGE &&
+               (src->typecode == 'q' || src->typecode == 'Q')) {
+        result_typecode = UUMPY_DEFAULT_TYPE;
+    #endif
     } else {
         result_typecode = src->typecode;
     }
@@ -456,6 +654,17 @@ static bool uumpy_reduction_find_unary_spec(unsigned int op_code,
     if ((src->typecode == UUMPY_DEFAULT_TYPE) &&
         (dest == NULL || dest->typecode == result_typecode)) {
         fastpath_type = UUMP_REDUCTION_FASTPATH_FLOAT;
+    #if UUMPY_SINGLE_KERNELS
+    } else if ((src->typecode == 'f') &&
+               (result_typecode == 'f') &&
+               (dest == NULL || dest->typecode == result_typecode)) {
+        fastpath_type = UUMP_REDUCTION_FASTPATH_SINGLE;
+    #endif
+    #if UUMPY_SPEEDUP_INT64
+    } else if ((src->typecode == 'q' || src->typecode == 'Q') &&
+               (dest == NULL || dest->typecode == result_typecode)) {
+        fastpath_type = UUMP_REDUCTION_FASTPATH_INT64;
+    #endif
     } else {
         fastpath_type = UUMP_REDUCTION_FASTPATH_NONE;
     }
@@ -502,6 +711,79 @@ static bool uumpy_reduction_find_unary_spec(unsigned int op_code,
             break;
         }
     }
+
+    #if UUMPY_SINGLE_KERNELS
+    if (fastpath_type == UUMP_REDUCTION_FASTPATH_SINGLE) {
+        // The state is wider than the result
+        spec_out->state_size = sizeof(mp_float_t);
+
+        switch (op_code) {
+        case UUMPY_REDUCTION_OP_MAX:
+            spec_out->init_func = NULL;
+            spec_out->iter_func = &uumpy_reduction_max_single_op;
+            break;
+        case UUMPY_REDUCTION_OP_MIN:
+            spec_out->init_func = NULL;
+            spec_out->iter_func = &uumpy_reduction_min_single_op;
+            break;
+        case UUMPY_REDUCTION_OP_SUM:
+            spec_out->init_func = &uumpy_reduction_init_zero_float;
+            spec_out->iter_func = &uumpy_reduction_sum_single_op;
+            break;
+        case UUMPY_REDUCTION_OP_PROD:
+            spec_out->init_func = &uumpy_reduction_init_one_float;
+            spec_out->iter_func = &uumpy_reduction_prod_single_op;
+            break;
+        case UUMPY_REDUCTION_OP_AVERAGE:
+            spec_out->init_func = &uumpy_reduction_init_zero_float;
+            spec_out->iter_func = &uumpy_reduction_sum_single_op;
+            spec_out->finish_func = &uumpy_reduction_finish_average_single;
+            custom_final = true;
+            break;
+        default:
+            fastpath_type = UUMP_REDUCTION_FASTPATH_NONE;
+            break;
+        }
+    }
+    #endif
+
+    #if UUMPY_SPEEDUP_INT64
+    if (fastpath_type == UUMP_REDUCTION_FASTPATH_INT64) {
+        bool is_unsigned = (src->typecode == 'Q');
+
+        // The state is a full 64 bits even when the result is a float
+        spec_out->state_size = sizeof(int64_t);
+
+        switch (op_code) {
+        case UUMPY_REDUCTION_OP_MAX:
+            spec_out->init_func = NULL;
+            spec_out->iter_func = is_unsigned ? &uumpy_reduction_max_uint64_op : &uumpy_reduction_max_int64_op;
+            break;
+        case UUMPY_REDUCTION_OP_MIN:
+            spec_out->init_func = NULL;
+            spec_out->iter_func = is_unsigned ? &uumpy_reduction_min_uint64_op : &uumpy_reduction_min_int64_op;
+            break;
+        case UUMPY_REDUCTION_OP_SUM:
+            spec_out->init_func = &uumpy_reduction_init_zero_int64;
+            spec_out->iter_func = &uumpy_reduction_sum_int64_op;
+            break;
+        case UUMPY_REDUCTION_OP_PROD:
+            spec_out->init_func = &uumpy_reduction_init_one_int64;
+            spec_out->iter_func = &uumpy_reduction_prod_int64_op;
+            break;
+        case UUMPY_REDUCTION_OP_AVERAGE:
+            spec_out->init_func = &uumpy_reduction_init_zero_int64;
+            spec_out->iter_func = &uumpy_reduction_sum_int64_op;
+            spec_out->finish_func = is_unsigned ? &uumpy_reduction_finish_average_uint64 :
+                                                  &uumpy_reduction_finish_average_int64;
+            custom_final = true;
+            break;
+        default:
+            fastpath_type = UUMP_REDUCTION_FASTPATH_NONE;
+            break;
+        }
+    }
+    #endif
     
     if (fastpath_type == UUMP_REDUCTION_FASTPATH_NONE) {
         switch (op_code) {
@@ -540,6 +822,14 @@ static bool uumpy_reduction_find_unary_spec(unsigned int op_code,
         } else {
             if (fastpath_type == UUMP_REDUCTION_FASTPATH_FLOAT) {
                 spec_out->finish_func = &uumpy_reduction_finish_store_float;
+            #if UUMPY_SINGLE_KERNELS
+            } else if (fastpath_type == UUMP_REDUCTION_FASTPATH_SINGLE) {
+                spec_out->finish_func = &uumpy_reduction_finish_store_single;
+            #endif
+            #if UUMPY_SPEEDUP_INT64
+            } else if (fastpath_type == UUMP_REDUCTION_FASTPATH_INT64) {
+                spec_out->finish_func = &uumpy_reduction_finish_store_int64;
+            #endif
             } else {
                 spec_out->finish_func = &uumpy_reduction_finish_store_obj;
             }
@@ -549,8 +839,34 @@ static bool uumpy_reduction_find_unary_spec(unsigned int op_code,
     return true;
 }
 
+static mp_obj_t uumpy_reduction_run(int op_code, uumpy_obj_ndarray_t *a, mp_obj_t axis,
+                                    uumpy_obj_ndarray_t *out) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    if ((op_code & UUMPY_REDUCTION_FLAG_1D_ONLY) &&
+        axis &&
+        mp_obj_is_type(axis, &mp_type_tuple)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("axis may not be a tuple"));
+    }
+
+    // Find the spec
+    uumpy_reduction_spec spec;
+    if (!uumpy_reduction_find_unary_spec(op_code, a, out, &spec)) {
+        mp_raise_NotImplementedError(MP_ERROR_TEXT("no reduction function for data type"));
+    }
+
+    // Execute the function
+    return uumpy_reduction_generic(a, out, axis, &spec);
+}
+
 static mp_obj_t uumpy_reduction_helper_1(int op_code, mp_uint_t n_args,
                                          const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    // Calls with only positional arguments don't need parsing
+    if (n_args >= 1 && n_args <= 2 && (kw_args == NULL || kw_args->used == 0)) {
+        return uumpy_reduction_run(op_code, MP_OBJ_TO_PTR(pos_args[0]),
+                                   (n_args == 2) ? pos_args[1] : mp_const_none, NULL);
+    }
+
     // Parse the arguments
     enum {
         ARG_a,
@@ -569,18 +885,6 @@ static mp_obj_t uumpy_reduction_helper_1(int op_code, mp_uint_t n_args,
 
     uumpy_obj_ndarray_t *a = MP_OBJ_TO_PTR(args[ARG_a].u_obj);
     uumpy_obj_ndarray_t *out = (args[ARG_out].u_obj != mp_const_none) ? MP_OBJ_TO_PTR(args[ARG_out].u_obj) : NULL;
-    
-    if ((op_code & UUMPY_REDUCTION_FLAG_1D_ONLY) &&
-        args[ARG_axis].u_obj &&
-        mp_obj_is_type(args[ARG_axis].u_obj, &mp_type_tuple)) {
-        mp_raise_ValueError(MP_ERROR_TEXT("axis may not be a tuple"));
-    }
-    
-    // Find the spec
-    uumpy_reduction_spec spec;
-    if (!uumpy_reduction_find_unary_spec(op_code, a, out, &spec)) {
-        mp_raise_NotImplementedError(MP_ERROR_TEXT("no reduction function for data type"));
-    }
 
     // If out is given and keepdims is set, create a view for the output
     if (args[ARG_keepdims].u_bool) {
@@ -588,8 +892,7 @@ static mp_obj_t uumpy_reduction_helper_1(int op_code, mp_uint_t n_args,
         mp_raise_NotImplementedError(MP_ERROR_TEXT("keepdims not currently supported"));
     }
     
-    // Execute the function
-    mp_obj_t result = uumpy_reduction_generic(a, out, args[ARG_axis].u_obj, &spec);
+    mp_obj_t result = uumpy_reduction_run(op_code, a, args[ARG_axis].u_obj, out);
     // TODO If keepdims is set and the result is new, reshape to restore missing dimensions
 
     return result;
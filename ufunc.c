@@ -36,52 +36,142 @@
 #include "moduumpy.h"
 #include "ufunc.h"
 
+// The state of an odometer-style walk over the outer dimensions of a set of
+// operands that all have the same shape. The indices count up through each
+// dimension and the offsets of each operand are kept up to date as we go.
 // This non-recursive implementation looks more complex than the obvious
 // recursive version but it both uses less stack and is faster.
+typedef struct _uumpy_iterator {
+    mp_int_t dim_count;
+    mp_int_t op_count;
+    mp_int_t *indices;
+    mp_int_t lengths[UUMPY_MAX_DIMS];
+    mp_int_t strides[UUMPY_MAX_OPERANDS][UUMPY_MAX_DIMS];
+    mp_int_t offsets[UUMPY_MAX_OPERANDS];
+} uumpy_iterator;
+
+// Returns false if there is nothing to iterate over
+static bool ufunc_iterator_init(uumpy_iterator *it, mp_int_t dim_count,
+                                mp_int_t op_count, uumpy_obj_ndarray_t **ops,
+                                mp_int_t *indices) {
+    bool non_empty = true;
+
+    it->dim_count = dim_count;
+    it->op_count = op_count;
+    it->indices = indices;
+
+    for (mp_int_t k=0; k < op_count; k++) {
+        it->offsets[k] = ops[k]->base_offset;
+        for (mp_int_t l=0; l < dim_count; l++) {
+            it->strides[k][l] = ops[k]->dim_info[l].stride;
+        }
+    }
+
+    for (mp_int_t l=0; l < dim_count; l++) {
+        it->lengths[l] = ops[0]->dim_info[l].length;
+        indices[l] = 0;
+        if (it->lengths[l] == 0) {
+            non_empty = false;
+        }
+    }
+
+    return non_empty;
+}
+
+// Step to the next position. Returns false once every position is done.
+static inline bool ufunc_iterator_next(uumpy_iterator *it) {
+    for (mp_int_t l = it->dim_count-1; l >= 0; l--) {
+        for (mp_int_t k=0; k < it->op_count; k++) {
+            it->offsets[k] += it->strides[k][l];
+        }
+
+        if (++it->indices[l] < it->lengths[l]) {
+            return true;
+        }
+
+        // Reset this row and allow moving on to the next one
+        it->indices[l] = 0;
+        for (mp_int_t k=0; k < it->op_count; k++) {
+            it->offsets[k] -= it->lengths[l] * it->strides[k][l];
+        }
+    }
+
+    return false;
+}
+
 bool ufunc_apply_binary(uumpy_obj_ndarray_t *dest,
                         uumpy_obj_ndarray_t *src1,
                         uumpy_obj_ndarray_t *src2,
                         struct _uumpy_universal_spec *spec) {
-    mp_int_t iterate_layers = dest->dim_count - spec->layers;
-    uumpy_dim_info * dim_info = dest->dim_info;
+    // Kernels that box values can allocate on any element
+    if (spec->boxed) {
+        UUMPY_CHECK_ALLOC();
+    }
+
+    uumpy_obj_ndarray_t *ops[3] = {dest, src1, src2};
     mp_int_t layer_indices[UUMPY_MAX_DIMS];
-    mp_int_t dest_offset = dest->base_offset;
-    mp_int_t src1_offset = src1->base_offset;
-    mp_int_t src2_offset = src2->base_offset;
+    mp_int_t depth = dest->dim_count - spec->layers;
+    uumpy_iterator it;
     bool result = true;
-    mp_int_t l;
 
     spec->indices = layer_indices;
-    
-    // The layer_indices count down, since it's quicker
-    for (mp_int_t i=0; i < iterate_layers; i++) {
-        layer_indices[i] = 0;
-    }
 
-    do {
-        result &= spec->apply_fn.binary(iterate_layers,
-                                        dest, dest_offset,
-                                        src1, src1_offset,
-                                        src2, src2_offset,
-                                        spec);
-        for (l = iterate_layers-1; l >=0; l--) {
-            src1_offset += src1->dim_info[l].stride;
-            src2_offset += src2->dim_info[l].stride;
-            dest_offset += dim_info[l].stride;
-            layer_indices[l]++;
+#if UUMPY_SPEEDUP_RANK
+    if (depth <= 2) {
+        // Walk up to two outer dimensions directly. With line kernels this
+        // covers arrays of up to three dimensions.
+        mp_int_t outer_length = 1, inner_length = 1;
+        mp_int_t inner_dim = (depth > 0) ? depth - 1 : 0;
+        mp_int_t outer_strides[3] = {0, 0, 0};
+        mp_int_t inner_strides[3] = {0, 0, 0};
+        mp_int_t offsets[3];
+
+        if (depth == 2) {
+            outer_length = dest->dim_info[0].length;
+            for (mp_int_t k=0; k < 3; k++) {
+                outer_strides[k] = ops[k]->dim_info[0].stride;
+            }
+        }
+        if (depth >= 1) {
+            inner_length = dest->dim_info[inner_dim].length;
+            for (mp_int_t k=0; k < 3; k++) {
+                inner_strides[k] = ops[k]->dim_info[inner_dim].stride;
+            }
+        }
 
-            if (layer_indices[l] < dim_info[l].length) {
-                break;
-            } else {
-                // Reset this row and allow moving on to the next one
-                size_t ll = dim_info[l].length;
-                layer_indices[l] = 0;
-                src1_offset -= ll * src1->dim_info[l].stride;
-                src2_offset -= ll * src2->dim_info[l].stride;
-                dest_offset -= ll * dim_info[l].stride;
+        for (mp_int_t i=0; i < outer_length; i++) {
+            layer_indices[0] = i;
+            for (mp_int_t k=0; k < 3; k++) {
+                offsets[k] = ops[k]->base_offset + i * outer_strides[k];
+            }
+            for (mp_int_t j=0; j < inner_length; j++) {
+                layer_indices[inner_dim] = j;
+                result &= spec->apply_fn.binary(depth,
+                                                dest, offsets[0],
+                                                src1, offsets[1],
+                                                src2, offsets[2],
+                                                spec);
+                offsets[0] += inner_strides[0];
+                offsets[1] += inner_strides[1];
+                offsets[2] += inner_strides[2];
             }
         }
-    } while (l >= 0);
+
+        return result;
+    }
+#endif
+
+    if (!ufunc_iterator_init(&it, depth, 3, ops, layer_indices)) {
+        return true;
+    }
+
+    do {
+        result &= spec->apply_fn.binary(it.dim_count,
+                                        dest, it.offsets[0],
+                                        src1, it.offsets[1],
+                                        src2, it.offsets[2],
+                                        spec);
+    } while (ufunc_iterator_next(&it));
 
     return result;
 }
@@ -89,46 +179,378 @@ bool ufunc_apply_binary(uumpy_obj_ndarray_t *dest,
 bool ufunc_apply_unary(uumpy_obj_ndarray_t *dest,
                        uumpy_obj_ndarray_t *src,
                        uumpy_universal_spec *spec) {
-    size_t iterate_layers = dest->dim_count - spec->layers;
-    uumpy_dim_info * dim_info = dest->dim_info;
+    // Kernels that box values can allocate on any element
+    if (spec->boxed) {
+        UUMPY_CHECK_ALLOC();
+    }
+
+    uumpy_obj_ndarray_t *ops[2] = {dest, src};
     mp_int_t layer_indices[UUMPY_MAX_DIMS];
-    mp_int_t dest_offset = dest->base_offset;
-    mp_int_t src_offset = src->base_offset;
+    mp_int_t depth = dest->dim_count - spec->layers;
+    uumpy_iterator it;
     bool result = true;
-    mp_int_t l;
 
     spec->indices = layer_indices;
 
-    for (size_t i=0; i < iterate_layers; i++) {
-        layer_indices[i] = 0;
+#if UUMPY_SPEEDUP_RANK
+    if (depth <= 2) {
+        // As for the binary case
+        mp_int_t outer_length = 1, inner_length = 1;
+        mp_int_t inner_dim = (depth > 0) ? depth - 1 : 0;
+        mp_int_t outer_strides[2] = {0, 0};
+        mp_int_t inner_strides[2] = {0, 0};
+        mp_int_t offsets[2];
+
+        if (depth == 2) {
+            outer_length = dest->dim_info[0].length;
+            outer_strides[0] = dest->dim_info[0].stride;
+            outer_strides[1] = src->dim_info[0].stride;
+        }
+        if (depth >= 1) {
+            inner_length = dest->dim_info[inner_dim].length;
+            inner_strides[0] = dest->dim_info[inner_dim].stride;
+            inner_strides[1] = src->dim_info[inner_dim].stride;
+        }
+
+        for (mp_int_t i=0; i < outer_length; i++) {
+            layer_indices[0] = i;
+            offsets[0] = dest->base_offset + i * outer_strides[0];
+            offsets[1] = src->base_offset + i * outer_strides[1];
+            for (mp_int_t j=0; j < inner_length; j++) {
+                layer_indices[inner_dim] = j;
+                result &= spec->apply_fn.unary(depth,
+                                               dest, offsets[0],
+                                               src, offsets[1],
+                                               spec);
+                offsets[0] += inner_strides[0];
+                offsets[1] += inner_strides[1];
+            }
+        }
+
+        return result;
+    }
+#endif
+
+    if (!ufunc_iterator_init(&it, depth, 2, ops, layer_indices)) {
+        return true;
     }
 
     do {
-        result &= spec->apply_fn.unary(iterate_layers,
-                                       dest, dest_offset,
-                                       src, src_offset,
+        result &= spec->apply_fn.unary(it.dim_count,
+                                       dest, it.offsets[0],
+                                       src, it.offsets[1],
                                        spec);
-        for (l = iterate_layers-1; l >=0; l--) {
-            src_offset += src->dim_info[l].stride;
-            dest_offset += dest->dim_info[l].stride;
-            layer_indices[l]++;
+    } while (ufunc_iterator_next(&it));
 
-            if (layer_indices[l] < dim_info[l].length) {
-                break;
-            } else {
-                // Reset this row and allow moving on to the next one
-                size_t ll = dest->dim_info[l].length;
-                layer_indices[l] = 0;
-                src_offset -= ll * src->dim_info[l].stride;
-                dest_offset -= ll * dest->dim_info[l].stride;
+    return result;
+}
+
+// Find the shape that a set of operands broadcast to. Any of the operands
+// can be NULL, in which case they are skipped. Returns the dimension count.
+mp_int_t ufunc_broadcast_shape(size_t op_count, uumpy_obj_ndarray_t **ops, mp_int_t *dims) {
+    mp_int_t dim_count = 0;
+
+    for (size_t k=0; k < op_count; k++) {
+        if (ops[k] && ops[k]->dim_count > dim_count) {
+            dim_count = ops[k]->dim_count;
+        }
+    }
+
+    for (mp_int_t i=0; i < dim_count; i++) {
+        dims[i] = 1;
+    }
+
+    for (size_t k=0; k < op_count; k++) {
+        if (!ops[k]) {
+            continue;
+        }
+        mp_int_t skip = dim_count - ops[k]->dim_count;
+        for (mp_int_t i=0; i < ops[k]->dim_count; i++) {
+            mp_int_t length = ops[k]->dim_info[i].length;
+            if (dims[skip + i] == 1) {
+                dims[skip + i] = length;
+            } else if (length != 1 && length != dims[skip + i]) {
+                mp_raise_ValueError(MP_ERROR_TEXT("operands could not be broadcast together"));
+            }
+        }
+    }
+
+    return dim_count;
+}
+
+// Apply a function across any number of operands. The first operand is
+// the output and the others are broadcast to its shape. Dimensions of
+// length one are dropped and dimensions that are contiguous in every
+// operand are merged, so the kernel is called with runs that are as long
+// as possible and the outer loop does as little work as possible.
+bool ufunc_apply_nary(size_t op_count, uumpy_obj_ndarray_t **ops,
+                      uumpy_universal_spec *spec) {
+    // Kernels that box values can allocate on any element
+    if (spec->boxed) {
+        UUMPY_CHECK_ALLOC();
+    }
+
+    uumpy_obj_ndarray_t *dest = ops[0];
+    mp_int_t dim_count = 0;
+    mp_int_t lengths[UUMPY_MAX_DIMS];
+    mp_int_t strides[UUMPY_MAX_OPERANDS][UUMPY_MAX_DIMS];
+
+    if (op_count > UUMPY_MAX_OPERANDS) {
+        mp_raise_ValueError(MP_ERROR_TEXT("too many operands"));
+    }
+
+    for (mp_int_t i=0; i < dest->dim_count; i++) {
+        mp_int_t length = dest->dim_info[i].length;
+
+        if (length == 0) {
+            return true;
+        }
+
+        // Work out the stride for this dimension in each operand
+        for (size_t k=0; k < op_count; k++) {
+            mp_int_t skip = dest->dim_count - ops[k]->dim_count;
+            mp_int_t stride = 0;
+
+            if (skip < 0) {
+                mp_raise_ValueError(MP_ERROR_TEXT("non-broadcastable output operand"));
+            }
+            if (i >= skip) {
+                uumpy_dim_info *info = &ops[k]->dim_info[i - skip];
+                if (info->length == length) {
+                    stride = info->stride;
+                } else if (info->length != 1) {
+                    mp_raise_ValueError(MP_ERROR_TEXT("operands could not be broadcast together"));
+                }
+            }
+            strides[k][dim_count] = stride;
+        }
+
+        if (length == 1) {
+            continue;
+        }
+
+        // Merge this dimension into the previous one if they are contiguous
+        bool merge = (dim_count > 0);
+        for (size_t k=0; merge && k < op_count; k++) {
+            merge = (strides[k][dim_count - 1] == strides[k][dim_count] * length);
+        }
+
+        if (merge) {
+            lengths[dim_count - 1] *= length;
+            for (size_t k=0; k < op_count; k++) {
+                strides[k][dim_count - 1] = strides[k][dim_count];
             }
+        } else {
+            lengths[dim_count] = length;
+            dim_count++;
         }
-    } while (l >= 0);
+    }
+
+    // A single element still needs one run of length one
+    if (dim_count == 0) {
+        lengths[0] = 1;
+        for (size_t k=0; k < op_count; k++) {
+            strides[k][0] = 0;
+        }
+        dim_count = 1;
+    }
+
+    mp_int_t layer_indices[UUMPY_MAX_DIMS];
+    mp_int_t value_sizes[UUMPY_MAX_OPERANDS];
+    uumpy_iterator it;
+    void *data[UUMPY_MAX_OPERANDS];
+    mp_int_t inner_strides[UUMPY_MAX_OPERANDS];
+    mp_int_t inner_length = lengths[dim_count - 1];
+    bool result = true;
+
+    it.dim_count = dim_count - 1;
+    it.op_count = op_count;
+    it.indices = layer_indices;
+    spec->indices = layer_indices;
+
+    for (size_t k=0; k < op_count; k++) {
+        value_sizes[k] = mp_binary_get_size('@', ops[k]->typecode, NULL);
+        inner_strides[k] = strides[k][dim_count - 1];
+        it.offsets[k] = ops[k]->base_offset;
+        for (mp_int_t l=0; l < it.dim_count; l++) {
+            it.strides[k][l] = strides[k][l];
+        }
+    }
+    for (mp_int_t l=0; l < it.dim_count; l++) {
+        it.lengths[l] = lengths[l];
+        layer_indices[l] = 0;
+    }
+
+    do {
+        for (size_t k=0; k < op_count; k++) {
+            data[k] = ((byte *) ops[k]->data) + it.offsets[k] * value_sizes[k];
+        }
+        result &= spec->apply_fn.nary(inner_length, data, inner_strides, spec);
+    } while (ufunc_iterator_next(&it));
 
     return result;
 }
 
 
+// Memory overlap. When the output of an element-wise operation shares
+// memory with one of its inputs we have to make sure that no element is
+// written before it has been read. The checks are cheap so they are only
+// expensive when there really is a hazard.
+
+// Find the lowest and highest element offsets that an array touches
+static void ufunc_extent(uumpy_obj_ndarray_t *a, mp_int_t *low, mp_int_t *high) {
+    *low = *high = a->base_offset;
+
+    for (mp_int_t i=0; i < a->dim_count; i++) {
+        mp_int_t span = (a->dim_info[i].length - 1) * a->dim_info[i].stride;
+        if (a->dim_info[i].length == 0) {
+            *high = *low - 1;
+            return;
+        }
+        if (span < 0) {
+            *low += span;
+        } else {
+            *high += span;
+        }
+    }
+}
+
+// Returns true if the two arrays might share any memory. This can give
+// false positives, for instance for interleaved slices, but never false
+// negatives.
+bool ufunc_may_overlap(uumpy_obj_ndarray_t *a, uumpy_obj_ndarray_t *b) {
+    if (a->data != b->data) {
+        return false;
+    }
+
+    mp_int_t a_low, a_high, b_low, b_high;
+    mp_int_t a_size = mp_binary_get_size('@', a->typecode, NULL);
+    mp_int_t b_size = mp_binary_get_size('@', b->typecode, NULL);
+
+    ufunc_extent(a, &a_low, &a_high);
+    ufunc_extent(b, &b_low, &b_high);
+
+    if (a_high < a_low || b_high < b_low) {
+        return false;
+    }
+
+    // Compare byte ranges since the types might be different sizes
+    return (a_low * a_size < (b_high + 1) * b_size) &&
+           (b_low * b_size < (a_high + 1) * a_size);
+}
+
+// Two arrays with identical layouts only ever meet at the same element,
+// which is safe for an element-wise operation
+static bool ufunc_same_layout(uumpy_obj_ndarray_t *a, uumpy_obj_ndarray_t *b) {
+    if (a->typecode != b->typecode || a->base_offset != b->base_offset ||
+        a->dim_count != b->dim_count) {
+        return false;
+    }
+
+    for (mp_int_t i=0; i < a->dim_count; i++) {
+        if (a->dim_info[i].length != b->dim_info[i].length ||
+            (a->dim_info[i].length > 1 && a->dim_info[i].stride != b->dim_info[i].stride)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// If two arrays of the same type have the same strides, and iterating over
+// them visits memory in strictly increasing order, then the hazard only
+// runs one way. Returns 1 if iterating forwards is safe, -1 if it has to
+// go backwards and 0 if neither will do.
+static int ufunc_safe_direction(uumpy_obj_ndarray_t *dest, uumpy_obj_ndarray_t *src) {
+    if (dest->typecode != src->typecode || dest->dim_count != src->dim_count) {
+        return 0;
+    }
+
+    mp_int_t inner_extent = 1;
+
+    for (mp_int_t i = dest->dim_count - 1; i >= 0; i--) {
+        mp_int_t length = dest->dim_info[i].length;
+        mp_int_t stride = dest->dim_info[i].stride;
+
+        if (length != src->dim_info[i].length) {
+            return 0;
+        }
+        if (length == 1) {
+            continue;
+        }
+        if (stride != src->dim_info[i].stride || stride < inner_extent) {
+            return 0;
+        }
+        inner_extent = stride * length;
+    }
+
+    // A source ahead of the destination is read before it is overwritten
+    return (src->base_offset >= dest->base_offset) ? 1 : -1;
+}
+
+// Make a view that visits the same elements in the reverse order
+static uumpy_obj_ndarray_t *ufunc_reversed_view(uumpy_obj_ndarray_t *src, uumpy_obj_ndarray_t *header,
+                                                uumpy_dim_info *dim_info) {
+    *header = *src;
+    header->simple = 0;
+    header->dim_info = dim_info;
+
+    for (mp_int_t i=0; i < src->dim_count; i++) {
+        header->base_offset += (src->dim_info[i].length - 1) * src->dim_info[i].stride;
+        dim_info[i].length = src->dim_info[i].length;
+        dim_info[i].stride = -src->dim_info[i].stride;
+    }
+
+    return header;
+}
+
+// Make sure that ops[0] can be computed element by element from the other
+// operands, even if some of them share memory with it. Where possible the
+// iteration is turned round, by replacing every operand with a reversed
+// view held in the views storage. Otherwise the offending input is copied.
+void ufunc_resolve_overlap(size_t op_count, uumpy_obj_ndarray_t **ops,
+                           uumpy_iteration_views *views) {
+    uumpy_obj_ndarray_t *dest = ops[0];
+    int directions[UUMPY_MAX_OPERANDS];
+    bool need_backwards = false;
+    bool need_forwards = false;
+
+    for (size_t k=1; k < op_count; k++) {
+        directions[k] = 1;
+        if (ufunc_may_overlap(dest, ops[k]) && !ufunc_same_layout(dest, ops[k])) {
+            directions[k] = ufunc_safe_direction(dest, ops[k]);
+            if (directions[k] < 0) {
+                need_backwards = true;
+            } else if (directions[k] > 0) {
+                need_forwards = true;
+            }
+        }
+    }
+
+    // If the directions conflict then copy the ones that want to go backwards
+    if (need_backwards && need_forwards) {
+        for (size_t k=1; k < op_count; k++) {
+            if (directions[k] < 0) {
+                directions[k] = 0;
+            }
+        }
+        need_backwards = false;
+    }
+
+    for (size_t k=1; k < op_count; k++) {
+        if (directions[k] == 0) {
+            ops[k] = ndarray_new_from_ndarray(MP_OBJ_FROM_PTR(ops[k]), ops[k]->typecode);
+        }
+    }
+
+    if (need_backwards) {
+        for (size_t k=0; k < op_count; k++) {
+            ops[k] = ufunc_reversed_view(ops[k], &views->arrays[k], views->dim_info[k]);
+        }
+    }
+}
+
+
 // This is a fall-back copy function that lets micropython deal with casting.
 static bool ufunc_copy_fallback(size_t depth,
                                 uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
@@ -243,6 +665,889 @@ static bool ufunc_unary_float_func_floats_1d(size_t depth,
     return true;
 }
 
+#if UUMPY_SINGLE_KERNELS
+// As above for float32 arrays on double precision builds. The function is
+// still evaluated in double precision.
+static bool ufunc_unary_float_func_singles_1d(size_t depth,
+                                              uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                              uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                              struct _uumpy_universal_spec *spec) {
+    float *src_ptr = (float *) src->data;
+    float *dest_ptr = (float *) dest->data;
+    mp_int_t src_stride = src->dim_info[depth].stride;
+    mp_int_t dest_stride = dest->dim_info[depth].stride;
+
+    for (size_t i = dest->dim_info[depth].length; i > 0; i--) {
+        mp_float_t x = src_ptr[src_offset];
+        mp_float_t ans = spec->extra.f_func(x);
+
+        if ((isnan(ans) && !isnan(x)) || (isinf(ans) && !isinf(x))) {
+            mp_raise_ValueError(MP_ERROR_TEXT("math domain error"));
+        }
+        dest_ptr[dest_offset] = (float) ans;
+
+        src_offset += src_stride;
+        dest_offset += dest_stride;
+    }
+
+    return true;
+}
+#endif
+
+// Buffered casting. The typed kernels below work on runs of the default
+// float type (or of mp_int_t for small integer types). Operands of other
+// types are converted a chunk at a time through small buffers on the stack
+// and results are converted back as they are stored, so any mix of types
+// can use the same few kernels rather than boxing every element.
+
+static bool ufunc_is_float_type(char typecode) {
+    return typecode == 'f' || typecode == 'd';
+}
+
+// Types whose values always fit in an mp_int_t
+static bool ufunc_is_small_int_type(char typecode) {
+    return typecode == 'b' || typecode == 'B' ||
+           typecode == 'h' || typecode == 'H' ||
+           typecode == 'i';
+}
+
+// Integer types, whose values all fit in an int64_t or, for 'Q', uint64_t
+static bool ufunc_is_int_type(char typecode) {
+    switch (typecode) {
+    case 'b': case 'B': case 'h': case 'H': case 'i': case 'I':
+    case 'l': case 'L': case 'q': case 'Q':
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool ufunc_is_unsigned_type(char typecode) {
+    return typecode == 'B' || typecode == 'H' || typecode == 'I' ||
+           typecode == 'L' || typecode == 'Q';
+}
+
+// Unsigned integer types that don't fit in an int64_t. 'L' is one on ports
+// where long has 64 bits.
+static bool ufunc_is_uint64_type(char typecode) {
+    return ufunc_is_unsigned_type(typecode) && mp_binary_get_size('@', typecode, NULL) == 8;
+}
+
+// Mixes of a signed integer type with a 64-bit unsigned one have no integer
+// type that holds all the values of both
+static bool ufunc_is_mixed_sign_int64(char lhs_type, char rhs_type) {
+    return ufunc_is_int_type(lhs_type) && ufunc_is_int_type(rhs_type) &&
+           ((ufunc_is_uint64_type(lhs_type) && !ufunc_is_unsigned_type(rhs_type)) ||
+            (ufunc_is_uint64_type(rhs_type) && !ufunc_is_unsigned_type(lhs_type)));
+}
+
+static bool ufunc_is_numeric_type(char typecode) {
+    switch (typecode) {
+    case 'b': case 'B': case 'h': case 'H': case 'i': case 'I':
+    case 'l': case 'L': case 'q': case 'Q': case 'f': case 'd':
+        return true;
+    default:
+        return false;
+    }
+}
+
+#define UUMPY_LOAD_CASE(code, type) \
+    case code: { \
+        const type *p = ((const type *) data) + offset; \
+        for (mp_int_t i=0; i < count; i++) { \
+            buf[i] = p[i * stride]; \
+        } \
+        break; \
+    }
+
+#define UUMPY_STORE_CASE(code, type) \
+    case code: { \
+        type *p = ((type *) data) + offset; \
+        for (mp_int_t i=0; i < count; i++) { \
+            p[i * stride] = (type) buf[i]; \
+        } \
+        break; \
+    }
+
+static void ufunc_load_floats(mp_float_t *buf, char typecode, const void *data,
+                              mp_int_t offset, mp_int_t stride, mp_int_t count) {
+    switch (typecode) {
+    UUMPY_LOAD_CASE('b', int8_t)
+    UUMPY_LOAD_CASE('B', uint8_t)
+    UUMPY_LOAD_CASE('h', int16_t)
+    UUMPY_LOAD_CASE('H', uint16_t)
+    UUMPY_LOAD_CASE('i', int)
+    UUMPY_LOAD_CASE('I', unsigned int)
+    UUMPY_LOAD_CASE('l', long)
+    UUMPY_LOAD_CASE('L', unsigned long)
+    UUMPY_LOAD_CASE('q', long long)
+    UUMPY_LOAD_CASE('Q', unsigned long long)
+    UUMPY_LOAD_CASE('f', float)
+    UUMPY_LOAD_CASE('d', double)
+    default:
+        for (mp_int_t i=0; i < count; i++) {
+            buf[i] = mp_obj_get_float(mp_binary_get_val_array(typecode, (void *) data, offset + i * stride));
+        }
+        break;
+    }
+}
+
+static void ufunc_store_floats(char typecode, void *data, mp_int_t offset, mp_int_t stride,
+                               mp_int_t count, const mp_float_t *buf) {
+    switch (typecode) {
+    UUMPY_STORE_CASE('b', int8_t)
+    UUMPY_STORE_CASE('B', uint8_t)
+    UUMPY_STORE_CASE('h', int16_t)
+    UUMPY_STORE_CASE('H', uint16_t)
+    UUMPY_STORE_CASE('i', int)
+    UUMPY_STORE_CASE('I', unsigned int)
+    UUMPY_STORE_CASE('l', long)
+    UUMPY_STORE_CASE('L', unsigned long)
+    UUMPY_STORE_CASE('q', long long)
+    UUMPY_STORE_CASE('Q', unsigned long long)
+    UUMPY_STORE_CASE('f', float)
+    UUMPY_STORE_CASE('d', double)
+    default:
+        for (mp_int_t i=0; i < count; i++) {
+            mp_binary_set_val_array(typecode, data, offset + i * stride, mp_obj_new_float(buf[i]));
+        }
+        break;
+    }
+}
+
+static void ufunc_load_ints(mp_int_t *buf, char typecode, const void *data,
+                            mp_int_t offset, mp_int_t stride, mp_int_t count) {
+    switch (typecode) {
+    UUMPY_LOAD_CASE('b', int8_t)
+    UUMPY_LOAD_CASE('B', uint8_t)
+    UUMPY_LOAD_CASE('h', int16_t)
+    UUMPY_LOAD_CASE('H', uint16_t)
+    UUMPY_LOAD_CASE('i', int)
+    default:
+        assert(0);
+        break;
+    }
+}
+
+// Integer results wrap around, as they do in numpy
+static void ufunc_store_ints(char typecode, void *data, mp_int_t offset, mp_int_t stride,
+                             mp_int_t count, const mp_int_t *buf) {
+    switch (typecode) {
+    UUMPY_STORE_CASE('b', int8_t)
+    UUMPY_STORE_CASE('B', uint8_t)
+    UUMPY_STORE_CASE('h', int16_t)
+    UUMPY_STORE_CASE('H', uint16_t)
+    UUMPY_STORE_CASE('i', int)
+    default:
+        assert(0);
+        break;
+    }
+}
+
+#if UUMPY_SPEEDUP_INT64
+// 64-bit integers are kept in int64_t buffers whatever their signedness;
+// 'Q' values keep their bits and the unsigned kernels reinterpret them.
+static void ufunc_load_int64s(int64_t *buf, char typecode, const void *data,
+                              mp_int_t offset, mp_int_t stride, mp_int_t count) {
+    switch (typecode) {
+    UUMPY_LOAD_CASE('b', int8_t)
+    UUMPY_LOAD_CASE('B', uint8_t)
+    UUMPY_LOAD_CASE('h', int16_t)
+    UUMPY_LOAD_CASE('H', uint16_t)
+    UUMPY_LOAD_CASE('i', int)
+    UUMPY_LOAD_CASE('I', unsigned int)
+    UUMPY_LOAD_CASE('l', long)
+    UUMPY_LOAD_CASE('L', unsigned long)
+    UUMPY_LOAD_CASE('q', long long)
+    UUMPY_LOAD_CASE('Q', unsigned long long)
+    default:
+        assert(0);
+        break;
+    }
+}
+
+static void ufunc_store_int64s(char typecode, void *data, mp_int_t offset, mp_int_t stride,
+                               mp_int_t count, const int64_t *buf) {
+    switch (typecode) {
+    UUMPY_STORE_CASE('b', int8_t)
+    UUMPY_STORE_CASE('B', uint8_t)
+    UUMPY_STORE_CASE('h', int16_t)
+    UUMPY_STORE_CASE('H', uint16_t)
+    UUMPY_STORE_CASE('i', int)
+    UUMPY_STORE_CASE('I', unsigned int)
+    UUMPY_STORE_CASE('l', long)
+    UUMPY_STORE_CASE('L', unsigned long)
+    UUMPY_STORE_CASE('q', long long)
+    UUMPY_STORE_CASE('Q', unsigned long long)
+    default:
+        assert(0);
+        break;
+    }
+}
+#endif
+
+#undef UUMPY_LOAD_CASE
+#undef UUMPY_STORE_CASE
+
+// Get a run of an operand as floats, either in place or via the buffer
+static const mp_float_t *ufunc_float_operand(uumpy_obj_ndarray_t *src, mp_int_t offset, mp_int_t stride,
+                                             mp_int_t count, mp_float_t *buf, mp_int_t *stride_out) {
+    if (src->typecode == UUMPY_DEFAULT_TYPE) {
+        *stride_out = stride;
+        return ((const mp_float_t *) src->data) + offset;
+    } else {
+        ufunc_load_floats(buf, src->typecode, src->data, offset, stride, count);
+        *stride_out = 1;
+        return buf;
+    }
+}
+
+#if UUMPY_SPEEDUP_INT64
+// As above for 64-bit integer operands
+static const int64_t *ufunc_int64_operand(uumpy_obj_ndarray_t *src, mp_int_t offset, mp_int_t stride,
+                                          mp_int_t count, int64_t *buf, mp_int_t *stride_out) {
+    if (src->typecode == 'q' || src->typecode == 'Q') {
+        *stride_out = stride;
+        return ((const int64_t *) src->data) + offset;
+    } else {
+        ufunc_load_int64s(buf, src->typecode, src->data, offset, stride, count);
+        *stride_out = 1;
+        return buf;
+    }
+}
+#endif
+
+static void ufunc_divide_by_zero(void) {
+    mp_raise_msg(&mp_type_ZeroDivisionError, MP_ERROR_TEXT("divide by zero"));
+}
+
+// The loops over lines of floating point values are written once, as the
+// cases of a switch on the operator, and instantiated for mp_float_t and,
+// on double precision builds, for float so that float32 arrays don't have
+// to be widened a buffer at a time.
+
+#define UUMPY_BINARY_LOOP(type, expr) \
+    for (mp_int_t i = count; i > 0; i--) { \
+        type x = *a; \
+        type y = *b; \
+        *dest = (expr); \
+        dest += dest_stride; \
+        a += a_stride; \
+        b += b_stride; \
+    }
+
+#define UUMPY_UNIT_LOOP(type, expr) \
+    for (mp_int_t i=0; i < count; i++) { \
+        type x = a[i]; \
+        type y = b[i]; \
+        dest[i] = (expr); \
+    }
+
+// The cheapest operations are limited by memory, so when a line is
+// contiguous in every operand they get plain indexed loops that the
+// compiler can vectorise.
+#define UUMPY_FLOAT_UNIT_CASES(type) \
+    case MP_BINARY_OP_ADD: \
+        UUMPY_UNIT_LOOP(type, x + y); \
+        break; \
+    case MP_BINARY_OP_SUBTRACT: \
+        UUMPY_UNIT_LOOP(type, x - y); \
+        break; \
+    case MP_BINARY_OP_MULTIPLY: \
+        UUMPY_UNIT_LOOP(type, x * y); \
+        break;
+
+#define UUMPY_FLOAT_BINARY_CASES(type, floor_fn, pow_fn) \
+    case MP_BINARY_OP_ADD: \
+        UUMPY_BINARY_LOOP(type, x + y); \
+        break; \
+    case MP_BINARY_OP_SUBTRACT: \
+        UUMPY_BINARY_LOOP(type, x - y); \
+        break; \
+    case MP_BINARY_OP_MULTIPLY: \
+        UUMPY_BINARY_LOOP(type, x * y); \
+        break; \
+    case MP_BINARY_OP_TRUE_DIVIDE: \
+        UUMPY_BINARY_LOOP(type, (y == 0) ? (ufunc_divide_by_zero(), 0) : x / y); \
+        break; \
+    case MP_BINARY_OP_FLOOR_DIVIDE: \
+        UUMPY_BINARY_LOOP(type, (y == 0) ? (ufunc_divide_by_zero(), 0) : floor_fn(x / y)); \
+        break; \
+    case MP_BINARY_OP_MODULO: \
+        /* The result takes the sign of the divisor, as in Python */ \
+        UUMPY_BINARY_LOOP(type, (y == 0) ? (ufunc_divide_by_zero(), 0) : x - y * floor_fn(x / y)); \
+        break; \
+    case MP_BINARY_OP_POWER: \
+        UUMPY_BINARY_LOOP(type, pow_fn(x, y)); \
+        break; \
+    case MP_BINARY_OP_LESS: \
+        UUMPY_BINARY_LOOP(type, x < y); \
+        break; \
+    case MP_BINARY_OP_MORE: \
+        UUMPY_BINARY_LOOP(type, x > y); \
+        break; \
+    case MP_BINARY_OP_EQUAL: \
+        UUMPY_BINARY_LOOP(type, x == y); \
+        break; \
+    case MP_BINARY_OP_LESS_EQUAL: \
+        UUMPY_BINARY_LOOP(type, x <= y); \
+        break; \
+    case MP_BINARY_OP_MORE_EQUAL: \
+        UUMPY_BINARY_LOOP(type, x >= y); \
+        break; \
+    case MP_BINARY_OP_NOT_EQUAL: \
+        UUMPY_BINARY_LOOP(type, x != y); \
+        break;
+
+// Lines whose operands all start on the data alignment boundary, which new
+// arrays do, use a copy of the unit loops that tells the compiler so, so
+// that it can skip the peeling loop and use aligned vector loads and stores.
+#define UUMPY_FLOAT_LOOP_FUNCTIONS(name, type, floor_fn, pow_fn) \
+    static bool name##_unit(mp_binary_op_t op, mp_int_t count, type *dest, \
+                            const type *a, const type *b) { \
+        switch (op) { \
+        UUMPY_FLOAT_UNIT_CASES(type) \
+        default: \
+            return false; \
+        } \
+        return true; \
+    } \
+    \
+    static bool name##_unit_aligned(mp_binary_op_t op, mp_int_t count, type *dest_in, \
+                                    const type *a_in, const type *b_in) { \
+        type *dest = UUMPY_ASSUME_ALIGNED(dest_in); \
+        const type *a = UUMPY_ASSUME_ALIGNED(a_in); \
+        const type *b = UUMPY_ASSUME_ALIGNED(b_in); \
+        switch (op) { \
+        UUMPY_FLOAT_UNIT_CASES(type) \
+        default: \
+            return false; \
+        } \
+        return true; \
+    } \
+    \
+    static bool name(mp_binary_op_t op, mp_int_t count, \
+                     type *dest, mp_int_t dest_stride, \
+                     const type *a, mp_int_t a_stride, \
+                     const type *b, mp_int_t b_stride) { \
+        if (dest_stride == 1 && a_stride == 1 && b_stride == 1) { \
+            if (UUMPY_IS_ALIGNED(dest) && UUMPY_IS_ALIGNED(a) && UUMPY_IS_ALIGNED(b)) { \
+                if (name##_unit_aligned(op, count, dest, a, b)) { \
+                    return true; \
+                } \
+            } else if (name##_unit(op, count, dest, a, b)) { \
+                return true; \
+            } \
+        } \
+        switch (op) { \
+        UUMPY_FLOAT_BINARY_CASES(type, floor_fn, pow_fn) \
+        default: \
+            return false; \
+        } \
+        return true; \
+    }
+
+UUMPY_FLOAT_LOOP_FUNCTIONS(ufunc_float_binary_loop, mp_float_t,
+                           MICROPY_FLOAT_C_FUN(floor), MICROPY_FLOAT_C_FUN(pow))
+
+#if UUMPY_SINGLE_KERNELS
+UUMPY_FLOAT_LOOP_FUNCTIONS(ufunc_single_binary_loop, float, floorf, powf)
+#endif
+
+#undef UUMPY_FLOAT_LOOP_FUNCTIONS
+#undef UUMPY_FLOAT_BINARY_CASES
+#undef UUMPY_FLOAT_UNIT_CASES
+#undef UUMPY_UNIT_LOOP
+#undef UUMPY_BINARY_LOOP
+
+// Floor division and modulo on integers follow Python's rounding. The most
+// negative value divided by -1 wraps rather than trapping.
+static mp_int_t ufunc_int_floor_divide(mp_int_t x, mp_int_t y) {
+    if (y == -1) {
+        return (mp_int_t) (0 - (mp_uint_t) x);
+    }
+    mp_int_t q = x / y;
+    if ((x % y != 0) && ((x < 0) != (y < 0))) {
+        q--;
+    }
+    return q;
+}
+
+static mp_int_t ufunc_int_modulo(mp_int_t x, mp_int_t y) {
+    if (y == -1) {
+        return 0;
+    }
+    return (mp_int_t) ((mp_uint_t) x - (mp_uint_t) y * (mp_uint_t) ufunc_int_floor_divide(x, y));
+}
+
+#define UUMPY_BINARY_LOOP(expr) \
+    for (mp_int_t i=0; i < count; i++) { \
+        mp_int_t x = a[i]; \
+        mp_int_t y = b[i]; \
+        dest[i] = (expr); \
+    }
+
+// The sums are done unsigned so that overflow wraps rather than being undefined
+static bool ufunc_int_binary_loop(mp_binary_op_t op, mp_int_t count,
+                                  mp_int_t *dest, const mp_int_t *a, const mp_int_t *b) {
+    switch (op) {
+    case MP_BINARY_OP_ADD:
+        UUMPY_BINARY_LOOP((mp_int_t) ((mp_uint_t) x + (mp_uint_t) y));
+        break;
+    case MP_BINARY_OP_SUBTRACT:
+        UUMPY_BINARY_LOOP((mp_int_t) ((mp_uint_t) x - (mp_uint_t) y));
+        break;
+    case MP_BINARY_OP_MULTIPLY:
+        UUMPY_BINARY_LOOP((mp_int_t) ((mp_uint_t) x * (mp_uint_t) y));
+        break;
+    case MP_BINARY_OP_FLOOR_DIVIDE:
+        UUMPY_BINARY_LOOP((y == 0) ? (ufunc_divide_by_zero(), 0) : ufunc_int_floor_divide(x, y));
+        break;
+    case MP_BINARY_OP_MODULO:
+        UUMPY_BINARY_LOOP((y == 0) ? (ufunc_divide_by_zero(), 0) : ufunc_int_modulo(x, y));
+        break;
+    case MP_BINARY_OP_AND:
+        UUMPY_BINARY_LOOP(x & y);
+        break;
+    case MP_BINARY_OP_OR:
+        UUMPY_BINARY_LOOP(x | y);
+        break;
+    case MP_BINARY_OP_XOR:
+        UUMPY_BINARY_LOOP(x ^ y);
+        break;
+    case MP_BINARY_OP_LESS:
+        UUMPY_BINARY_LOOP(x < y);
+        break;
+    case MP_BINARY_OP_MORE:
+        UUMPY_BINARY_LOOP(x > y);
+        break;
+    case MP_BINARY_OP_EQUAL:
+        UUMPY_BINARY_LOOP(x == y);
+        break;
+    case MP_BINARY_OP_LESS_EQUAL:
+        UUMPY_BINARY_LOOP(x <= y);
+        break;
+    case MP_BINARY_OP_MORE_EQUAL:
+        UUMPY_BINARY_LOOP(x >= y);
+        break;
+    case MP_BINARY_OP_NOT_EQUAL:
+        UUMPY_BINARY_LOOP(x != y);
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+#undef UUMPY_BINARY_LOOP
+
+#if UUMPY_SPEEDUP_INT64
+// The most negative value divided by -1 wraps, as it does in numpy, rather
+// than trapping
+static int64_t ufunc_int64_floor_divide(int64_t x, int64_t y) {
+    if (y == -1) {
+        return (int64_t) (0 - (uint64_t) x);
+    }
+    int64_t q = x / y;
+    if ((x % y != 0) && ((x < 0) != (y < 0))) {
+        q--;
+    }
+    return q;
+}
+
+static int64_t ufunc_int64_modulo(int64_t x, int64_t y) {
+    if (y == -1) {
+        return 0;
+    }
+    int64_t r = x % y;
+    if ((r != 0) && ((r < 0) != (y < 0))) {
+        r += y;
+    }
+    return r;
+}
+
+static uint64_t ufunc_uint64_divide(uint64_t x, uint64_t y) {
+    return x / y;
+}
+
+static uint64_t ufunc_uint64_modulo(uint64_t x, uint64_t y) {
+    return x % y;
+}
+
+#define UUMPY_BINARY_LOOP(type, expr) \
+    for (mp_int_t i = count; i > 0; i--) { \
+        type x = (type) *a; \
+        type y = (type) *b; \
+        *dest = (int64_t) (expr); \
+        dest += dest_stride; \
+        a += a_stride; \
+        b += b_stride; \
+    }
+
+// Signed and unsigned 64-bit values share the int64_t storage and only
+// differ in the division, modulo and comparisons. Sums are done unsigned so
+// that overflow wraps.
+#define UUMPY_INT64_LOOP_FUNCTION(name, type, divide_fn, modulo_fn) \
+    static bool name(mp_binary_op_t op, mp_int_t count, \
+                     int64_t *dest, mp_int_t dest_stride, \
+                     const int64_t *a, mp_int_t a_stride, \
+                     const int64_t *b, mp_int_t b_stride) { \
+        switch (op) { \
+        case MP_BINARY_OP_ADD: \
+            UUMPY_BINARY_LOOP(type, (uint64_t) x + (uint64_t) y); \
+            break; \
+        case MP_BINARY_OP_SUBTRACT: \
+            UUMPY_BINARY_LOOP(type, (uint64_t) x - (uint64_t) y); \
+            break; \
+        case MP_BINARY_OP_MULTIPLY: \
+            UUMPY_BINARY_LOOP(type, (uint64_t) x * (uint64_t) y); \
+            break; \
+        case MP_BINARY_OP_FLOOR_DIVIDE: \
+            UUMPY_BINARY_LOOP(type, (y == 0) ? (ufunc_divide_by_zero(), 0) : divide_fn(x, y)); \
+            break; \
+        case MP_BINARY_OP_MODULO: \
+            UUMPY_BINARY_LOOP(type, (y == 0) ? (ufunc_divide_by_zero(), 0) : modulo_fn(x, y)); \
+            break; \
+        case MP_BINARY_OP_AND: \
+            UUMPY_BINARY_LOOP(type, x & y); \
+            break; \
+        case MP_BINARY_OP_OR: \
+            UUMPY_BINARY_LOOP(type, x | y); \
+            break; \
+        case MP_BINARY_OP_XOR: \
+            UUMPY_BINARY_LOOP(type, x ^ y); \
+            break; \
+        case MP_BINARY_OP_LESS: \
+            UUMPY_BINARY_LOOP(type, x < y); \
+            break; \
+        case MP_BINARY_OP_MORE: \
+            UUMPY_BINARY_LOOP(type, x > y); \
+            break; \
+        case MP_BINARY_OP_EQUAL: \
+            UUMPY_BINARY_LOOP(type, x == y); \
+            break; \
+        case MP_BINARY_OP_LESS_EQUAL: \
+            UUMPY_BINARY_LOOP(type, x <= y); \
+            break; \
+        case MP_BINARY_OP_MORE_EQUAL: \
+            UUMPY_BINARY_LOOP(type, x >= y); \
+            break; \
+        case MP_BINARY_OP_NOT_EQUAL: \
+            UUMPY_BINARY_LOOP(type, x != y); \
+            break; \
+        default: \
+            return false; \
+        } \
+        return true; \
+    }
+
+UUMPY_INT64_LOOP_FUNCTION(ufunc_int64_binary_loop, int64_t, ufunc_int64_floor_divide, ufunc_int64_modulo)
+UUMPY_INT64_LOOP_FUNCTION(ufunc_uint64_binary_loop, uint64_t, ufunc_uint64_divide, ufunc_uint64_modulo)
+
+#undef UUMPY_INT64_LOOP_FUNCTION
+
+// A signed value has no common 64-bit type with a 64-bit unsigned one, so
+// they are compared by sign first. The arguments hold the bits of a signed
+// and an unsigned value respectively.
+static int ufunc_int64_uint64_compare(int64_t x, int64_t y) {
+    if (x < 0 || (uint64_t) x < (uint64_t) y) {
+        return -1;
+    }
+    return ((uint64_t) x == (uint64_t) y) ? 0 : 1;
+}
+
+static int ufunc_uint64_int64_compare(int64_t x, int64_t y) {
+    return -ufunc_int64_uint64_compare(y, x);
+}
+
+#define UUMPY_MIXED64_LOOP_FUNCTION(name, compare_fn) \
+    static bool name(mp_binary_op_t op, mp_int_t count, \
+                     int64_t *dest, mp_int_t dest_stride, \
+                     const int64_t *a, mp_int_t a_stride, \
+                     const int64_t *b, mp_int_t b_stride) { \
+        switch (op) { \
+        case MP_BINARY_OP_LESS: \
+            UUMPY_BINARY_LOOP(int64_t, compare_fn(x, y) < 0); \
+            break; \
+        case MP_BINARY_OP_MORE: \
+            UUMPY_BINARY_LOOP(int64_t, compare_fn(x, y) > 0); \
+            break; \
+        case MP_BINARY_OP_EQUAL: \
+            UUMPY_BINARY_LOOP(int64_t, compare_fn(x, y) == 0); \
+            break; \
+        case MP_BINARY_OP_LESS_EQUAL: \
+            UUMPY_BINARY_LOOP(int64_t, compare_fn(x, y) <= 0); \
+            break; \
+        case MP_BINARY_OP_MORE_EQUAL: \
+            UUMPY_BINARY_LOOP(int64_t, compare_fn(x, y) >= 0); \
+            break; \
+        case MP_BINARY_OP_NOT_EQUAL: \
+            UUMPY_BINARY_LOOP(int64_t, compare_fn(x, y) != 0); \
+            break; \
+        default: \
+            return false; \
+        } \
+        return true; \
+    }
+
+UUMPY_MIXED64_LOOP_FUNCTION(ufunc_int64_uint64_compare_loop, ufunc_int64_uint64_compare)
+UUMPY_MIXED64_LOOP_FUNCTION(ufunc_uint64_int64_compare_loop, ufunc_uint64_int64_compare)
+
+#undef UUMPY_MIXED64_LOOP_FUNCTION
+#undef UUMPY_BINARY_LOOP
+#endif
+
+// Binary operations computed in floating point, one line at a time
+static bool ufunc_binary_float_buffered(size_t depth,
+                                        uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                        uumpy_obj_ndarray_t *src1, mp_int_t src1_offset,
+                                        uumpy_obj_ndarray_t *src2, mp_int_t src2_offset,
+                                        struct _uumpy_universal_spec *spec) {
+    mp_float_t buf1[UUMPY_BUFFER_SIZE];
+    mp_float_t buf2[UUMPY_BUFFER_SIZE];
+    mp_float_t buf_out[UUMPY_BUFFER_SIZE];
+    mp_int_t length = dest->dim_info[depth].length;
+    mp_int_t dest_stride = dest->dim_info[depth].stride;
+    mp_int_t src1_stride = src1->dim_info[depth].stride;
+    mp_int_t src2_stride = src2->dim_info[depth].stride;
+    bool direct_out = (dest->typecode == UUMPY_DEFAULT_TYPE);
+
+    for (mp_int_t done = 0; done < length; ) {
+        mp_int_t count = MIN(UUMPY_BUFFER_SIZE, length - done);
+        mp_int_t a_stride, b_stride;
+        const mp_float_t *a = ufunc_float_operand(src1, src1_offset, src1_stride, count, buf1, &a_stride);
+        const mp_float_t *b = ufunc_float_operand(src2, src2_offset, src2_stride, count, buf2, &b_stride);
+
+        if (direct_out) {
+            ufunc_float_binary_loop(spec->extra.b_op, count,
+                                    ((mp_float_t *) dest->data) + dest_offset, dest_stride,
+                                    a, a_stride, b, b_stride);
+        } else {
+            ufunc_float_binary_loop(spec->extra.b_op, count, buf_out, 1, a, a_stride, b, b_stride);
+            ufunc_store_floats(dest->typecode, dest->data, dest_offset, dest_stride, count, buf_out);
+        }
+
+        done += count;
+        dest_offset += count * dest_stride;
+        src1_offset += count * src1_stride;
+        src2_offset += count * src2_stride;
+    }
+
+    return true;
+}
+
+#if UUMPY_SINGLE_KERNELS
+// Binary operations where both operands and the result are float32, on
+// builds where the default type is double
+static bool ufunc_binary_single(size_t depth,
+                                uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                uumpy_obj_ndarray_t *src1, mp_int_t src1_offset,
+                                uumpy_obj_ndarray_t *src2, mp_int_t src2_offset,
+                                struct _uumpy_universal_spec *spec) {
+    return ufunc_single_binary_loop(spec->extra.b_op, dest->dim_info[depth].length,
+                                    ((float *) dest->data) + dest_offset, dest->dim_info[depth].stride,
+                                    ((const float *) src1->data) + src1_offset, src1->dim_info[depth].stride,
+                                    ((const float *) src2->data) + src2_offset, src2->dim_info[depth].stride);
+}
+#endif
+
+#if UUMPY_SPEEDUP_INT64
+typedef bool (*ufunc_int64_loop_fn)(mp_binary_op_t op, mp_int_t count,
+                                    int64_t *dest, mp_int_t dest_stride,
+                                    const int64_t *a, mp_int_t a_stride,
+                                    const int64_t *b, mp_int_t b_stride);
+
+// Binary operations on integers that need 64 bits, one line at a time. Lines
+// of 'q' and 'Q' values are used in place.
+static bool ufunc_binary_int64_line(ufunc_int64_loop_fn loop, size_t depth,
+                                    uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                    uumpy_obj_ndarray_t *src1, mp_int_t src1_offset,
+                                    uumpy_obj_ndarray_t *src2, mp_int_t src2_offset,
+                                    struct _uumpy_universal_spec *spec) {
+    int64_t buf1[UUMPY_BUFFER_SIZE];
+    int64_t buf2[UUMPY_BUFFER_SIZE];
+    int64_t buf_out[UUMPY_BUFFER_SIZE];
+    mp_int_t length = dest->dim_info[depth].length;
+    mp_int_t dest_stride = dest->dim_info[depth].stride;
+    mp_int_t src1_stride = src1->dim_info[depth].stride;
+    mp_int_t src2_stride = src2->dim_info[depth].stride;
+    bool direct_out = (dest->typecode == 'q' || dest->typecode == 'Q');
+
+    for (mp_int_t done = 0; done < length; ) {
+        mp_int_t count = MIN(UUMPY_BUFFER_SIZE, length - done);
+        mp_int_t a_stride, b_stride;
+        const int64_t *a = ufunc_int64_operand(src1, src1_offset, src1_stride, count, buf1, &a_stride);
+        const int64_t *b = ufunc_int64_operand(src2, src2_offset, src2_stride, count, buf2, &b_stride);
+
+        if (direct_out) {
+            loop(spec->extra.b_op, count,
+                 ((int64_t *) dest->data) + dest_offset, dest_stride,
+                 a, a_stride, b, b_stride);
+        } else {
+            loop(spec->extra.b_op, count, buf_out, 1, a, a_stride, b, b_stride);
+            ufunc_store_int64s(dest->typecode, dest->data, dest_offset, dest_stride, count, buf_out);
+        }
+
+        done += count;
+        dest_offset += count * dest_stride;
+        src1_offset += count * src1_stride;
+        src2_offset += count * src2_stride;
+    }
+
+    return true;
+}
+
+static bool ufunc_binary_int64_buffered(size_t depth,
+                                        uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                        uumpy_obj_ndarray_t *src1, mp_int_t src1_offset,
+                                        uumpy_obj_ndarray_t *src2, mp_int_t src2_offset,
+                                        struct _uumpy_universal_spec *spec) {
+    return ufunc_binary_int64_line(&ufunc_int64_binary_loop, depth,
+                                   dest, dest_offset, src1, src1_offset, src2, src2_offset, spec);
+}
+
+// Both operands unsigned
+static bool ufunc_binary_uint64_buffered(size_t depth,
+                                         uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                         uumpy_obj_ndarray_t *src1, mp_int_t src1_offset,
+                                         uumpy_obj_ndarray_t *src2, mp_int_t src2_offset,
+                                         struct _uumpy_universal_spec *spec) {
+    return ufunc_binary_int64_line(&ufunc_uint64_binary_loop, depth,
+                                   dest, dest_offset, src1, src1_offset, src2, src2_offset, spec);
+}
+
+// Comparisons of a signed first operand with a 64-bit unsigned second one
+static bool ufunc_compare_int64_uint64_buffered(size_t depth,
+                                                uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                                uumpy_obj_ndarray_t *src1, mp_int_t src1_offset,
+                                                uumpy_obj_ndarray_t *src2, mp_int_t src2_offset,
+                                                struct _uumpy_universal_spec *spec) {
+    return ufunc_binary_int64_line(&ufunc_int64_uint64_compare_loop, depth,
+                                   dest, dest_offset, src1, src1_offset, src2, src2_offset, spec);
+}
+
+// And the other way around
+static bool ufunc_compare_uint64_int64_buffered(size_t depth,
+                                                uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                                uumpy_obj_ndarray_t *src1, mp_int_t src1_offset,
+                                                uumpy_obj_ndarray_t *src2, mp_int_t src2_offset,
+                                                struct _uumpy_universal_spec *spec) {
+    return ufunc_binary_int64_line(&ufunc_uint64_int64_compare_loop, depth,
+                                   dest, dest_offset, src1, src1_offset, src2, src2_offset, spec);
+}
+#endif
+
+// Binary operations on small integer types, computed as mp_int_t
+static bool ufunc_binary_int_buffered(size_t depth,
+                                      uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                      uumpy_obj_ndarray_t *src1, mp_int_t src1_offset,
+                                      uumpy_obj_ndarray_t *src2, mp_int_t src2_offset,
+                                      struct _uumpy_universal_spec *spec) {
+    mp_int_t buf1[UUMPY_BUFFER_SIZE];
+    mp_int_t buf2[UUMPY_BUFFER_SIZE];
+    mp_int_t length = dest->dim_info[depth].length;
+    mp_int_t dest_stride = dest->dim_info[depth].stride;
+    mp_int_t src1_stride = src1->dim_info[depth].stride;
+    mp_int_t src2_stride = src2->dim_info[depth].stride;
+
+    for (mp_int_t done = 0; done < length; ) {
+        mp_int_t count = MIN(UUMPY_BUFFER_SIZE, length - done);
+
+        ufunc_load_ints(buf1, src1->typecode, src1->data, src1_offset, src1_stride, count);
+        ufunc_load_ints(buf2, src2->typecode, src2->data, src2_offset, src2_stride, count);
+        // The result can overwrite the first input
+        ufunc_int_binary_loop(spec->extra.b_op, count, buf1, buf1, buf2);
+        ufunc_store_ints(dest->typecode, dest->data, dest_offset, dest_stride, count, buf1);
+
+        done += count;
+        dest_offset += count * dest_stride;
+        src1_offset += count * src1_stride;
+        src2_offset += count * src2_stride;
+    }
+
+    return true;
+}
+
+// Applies a float function to a whole line of any numeric types
+static bool ufunc_unary_float_func_buffered(size_t depth,
+                                            uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                            uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                            struct _uumpy_universal_spec *spec) {
+    mp_float_t buf[UUMPY_BUFFER_SIZE];
+    mp_int_t length = dest->dim_info[depth].length;
+    mp_int_t dest_stride = dest->dim_info[depth].stride;
+    mp_int_t src_stride = src->dim_info[depth].stride;
+
+    for (mp_int_t done = 0; done < length; ) {
+        mp_int_t count = MIN(UUMPY_BUFFER_SIZE, length - done);
+
+        ufunc_load_floats(buf, src->typecode, src->data, src_offset, src_stride, count);
+        for (mp_int_t i=0; i < count; i++) {
+            mp_float_t x = buf[i];
+            mp_float_t ans = spec->extra.f_func(x);
+
+            if ((isnan(ans) && !isnan(x)) || (isinf(ans) && !isinf(x))) {
+                mp_raise_ValueError(MP_ERROR_TEXT("math domain error"));
+            }
+            buf[i] = ans;
+        }
+        ufunc_store_floats(dest->typecode, dest->data, dest_offset, dest_stride, count, buf);
+
+        done += count;
+        dest_offset += count * dest_stride;
+        src_offset += count * src_stride;
+    }
+
+    return true;
+}
+
+// Copies a line converting between types, via floats unless both types are
+// integers
+static bool ufunc_copy_buffered(size_t depth,
+                                uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                struct _uumpy_universal_spec *spec) {
+    (void) spec;
+    union {
+        mp_float_t f[UUMPY_BUFFER_SIZE];
+        mp_int_t i[UUMPY_BUFFER_SIZE];
+        #if UUMPY_SPEEDUP_INT64
+        int64_t q[UUMPY_BUFFER_SIZE];
+        #endif
+    } buf;
+    mp_int_t length = dest->dim_info[depth].length;
+    mp_int_t dest_stride = dest->dim_info[depth].stride;
+    mp_int_t src_stride = src->dim_info[depth].stride;
+    bool as_ints = ufunc_is_small_int_type(src->typecode) && ufunc_is_small_int_type(dest->typecode);
+    #if UUMPY_SPEEDUP_INT64
+    bool as_int64s = !as_ints && ufunc_is_int_type(src->typecode) && ufunc_is_int_type(dest->typecode);
+    #endif
+
+    for (mp_int_t done = 0; done < length; ) {
+        mp_int_t count = MIN(UUMPY_BUFFER_SIZE, length - done);
+
+        if (as_ints) {
+            ufunc_load_ints(buf.i, src->typecode, src->data, src_offset, src_stride, count);
+            ufunc_store_ints(dest->typecode, dest->data, dest_offset, dest_stride, count, buf.i);
+        #if UUMPY_SPEEDUP_INT64
+        } else if (as_int64s) {
+            ufunc_load_int64s(buf.q, src->typecode, src->data, src_offset, src_stride, count);
+            ufunc_store_int64s(dest->typecode, dest->data, dest_offset, dest_stride, count, buf.q);
+        #endif
+        } else {
+            ufunc_load_floats(buf.f, src->typecode, src->data, src_offset, src_stride, count);
+            ufunc_store_floats(dest->typecode, dest->data, dest_offset, dest_stride, count, buf.f);
+        }
+
+        done += count;
+        dest_offset += count * dest_stride;
+        src_offset += count * src_stride;
+    }
+
+    return true;
+}
+
 void ufunc_mul_acc_fallback(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
                             uumpy_obj_ndarray_t *src1, mp_int_t src1_offset, mp_int_t src1_dim,
                             uumpy_obj_ndarray_t *src2, mp_int_t src2_offset, mp_int_t src2_dim) {
@@ -279,14 +1584,41 @@ void ufunc_mul_acc_fallback(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
 }
 
 static char type_expand(char lhs_type, char rhs_type) {
-    // FIXME: This is not the right way to do this...
+    // FIXME: This is not the right way to do this for integers...
+    if (ufunc_is_float_type(rhs_type) && !ufunc_is_float_type(lhs_type)) {
+        return rhs_type;
+    } else if (rhs_type == 'd' && lhs_type == 'f') {
+        return rhs_type;
+    } else if (ufunc_is_mixed_sign_int64(lhs_type, rhs_type)) {
+        // As numpy does, rather than wrap large unsigned values
+        return UUMPY_DEFAULT_TYPE;
+    } else if (ufunc_is_int_type(lhs_type) && ufunc_is_int_type(rhs_type) &&
+               (lhs_type == 'q' || lhs_type == 'Q' || rhs_type == 'q' || rhs_type == 'Q')) {
+        // 64-bit integers are never narrowed, and stay unsigned only if
+        // both sides are
+        return (ufunc_is_unsigned_type(lhs_type) && ufunc_is_unsigned_type(rhs_type)) ? 'Q' : 'q';
+    }
     return lhs_type;
 }
 
+static bool ufunc_is_comparison_op(mp_binary_op_t op) {
+    switch (op) {
+    case MP_BINARY_OP_LESS:
+    case MP_BINARY_OP_MORE:
+    case MP_BINARY_OP_EQUAL:
+    case MP_BINARY_OP_LESS_EQUAL:
+    case MP_BINARY_OP_MORE_EQUAL:
+    case MP_BINARY_OP_NOT_EQUAL:
+        return true;
+    default:
+        return false;
+    }
+}
+
 // Find the 'best' universal spec for the operation given the types
-void ufunc_find_binary_op_spec(uumpy_obj_ndarray_t *src1, uumpy_obj_ndarray_t *src2,
-                               char *dest_type_in_out, mp_binary_op_t op,
-                               uumpy_universal_spec *spec_out) {
+static void ufunc_resolve_binary_op_spec(uumpy_obj_ndarray_t *src1, uumpy_obj_ndarray_t *src2,
+                                         char *dest_type_in_out, mp_binary_op_t op,
+                                         uumpy_universal_spec *spec_out) {
     char result_type = *dest_type_in_out;
     if (result_type == 0) {
         switch (op) {
@@ -327,9 +1659,168 @@ void ufunc_find_binary_op_spec(uumpy_obj_ndarray_t *src1, uumpy_obj_ndarray_t *s
         .extra.b_op = op,
     };
 
+    // The buffered kernels work a line at a time so need at least one dimension
+    if (src1->dim_count > 0) {
+        bool comparison = ufunc_is_comparison_op(op);
+
+        #if UUMPY_SPEEDUP_FLOAT
+        if (ufunc_is_numeric_type(src1->typecode) &&
+            ufunc_is_numeric_type(src2->typecode) &&
+            ufunc_is_numeric_type(result_type) &&
+            (ufunc_is_float_type(result_type) ||
+             (comparison && (ufunc_is_float_type(src1->typecode) || ufunc_is_float_type(src2->typecode))))) {
+            switch (op) {
+            case MP_BINARY_OP_ADD:
+            case MP_BINARY_OP_SUBTRACT:
+            case MP_BINARY_OP_MULTIPLY:
+            case MP_BINARY_OP_TRUE_DIVIDE:
+            case MP_BINARY_OP_FLOOR_DIVIDE:
+            case MP_BINARY_OP_MODULO:
+            case MP_BINARY_OP_POWER:
+                spec.layers = 1;
+                spec.apply_fn.binary = &ufunc_binary_float_buffered;
+                break;
+            default:
+                if (comparison) {
+                    spec.layers = 1;
+                    spec.apply_fn.binary = &ufunc_binary_float_buffered;
+                }
+                break;
+            }
+        }
+        #endif
+
+        #if UUMPY_SINGLE_KERNELS
+        if (spec.layers && result_type == 'f' &&
+            src1->typecode == 'f' && src2->typecode == 'f') {
+            spec.apply_fn.binary = &ufunc_binary_single;
+        }
+        #endif
+
+        #if UUMPY_SPEEDUP_INT
+        if (ufunc_is_small_int_type(src1->typecode) &&
+            ufunc_is_small_int_type(src2->typecode) &&
+            ufunc_is_small_int_type(result_type)) {
+            switch (op) {
+            case MP_BINARY_OP_ADD:
+            case MP_BINARY_OP_SUBTRACT:
+            case MP_BINARY_OP_MULTIPLY:
+            case MP_BINARY_OP_FLOOR_DIVIDE:
+            case MP_BINARY_OP_MODULO:
+            case MP_BINARY_OP_AND:
+            case MP_BINARY_OP_OR:
+            case MP_BINARY_OP_XOR:
+                spec.layers = 1;
+                spec.apply_fn.binary = &ufunc_binary_int_buffered;
+                break;
+            default:
+                if (comparison) {
+                    spec.layers = 1;
+                    spec.apply_fn.binary = &ufunc_binary_int_buffered;
+                }
+                break;
+            }
+        }
+        #endif
+
+        #if UUMPY_SPEEDUP_INT64
+        // Any other mix of integer types, computed in 64 bits. Arithmetic
+        // on a signed type and a 64-bit unsigned one is done in floating
+        // point, but comparisons of them have kernels of their own.
+        if (spec.layers == 0 &&
+            ufunc_is_int_type(src1->typecode) &&
+            ufunc_is_int_type(src2->typecode) &&
+            ufunc_is_mixed_sign_int64(src1->typecode, src2->typecode)) {
+            if (comparison && ufunc_is_int_type(result_type)) {
+                spec.layers = 1;
+                spec.apply_fn.binary = ufunc_is_uint64_type(src1->typecode) ?
+                    &ufunc_compare_uint64_int64_buffered : &ufunc_compare_int64_uint64_buffered;
+            }
+        } else if (spec.layers == 0 &&
+            ufunc_is_int_type(src1->typecode) &&
+            ufunc_is_int_type(src2->typecode) &&
+            ufunc_is_int_type(result_type)) {
+            switch (op) {
+            case MP_BINARY_OP_ADD:
+            case MP_BINARY_OP_SUBTRACT:
+            case MP_BINARY_OP_MULTIPLY:
+            case MP_BINARY_OP_FLOOR_DIVIDE:
+            case MP_BINARY_OP_MODULO:
+            case MP_BINARY_OP_AND:
+            case MP_BINARY_OP_OR:
+            case MP_BINARY_OP_XOR:
+                spec.layers = 1;
+                break;
+            default:
+                if (comparison) {
+                    spec.layers = 1;
+                }
+                break;
+            }
+            if (spec.layers) {
+                spec.apply_fn.binary =
+                    (ufunc_is_unsigned_type(src1->typecode) && ufunc_is_unsigned_type(src2->typecode)) ?
+                    &ufunc_binary_uint64_buffered : &ufunc_binary_int64_buffered;
+            }
+        }
+        #endif
+
+        (void) comparison;
+    }
+
+    spec.boxed = (spec.apply_fn.binary == &ufunc_universal_binary_op_fallback);
+
     *spec_out = spec;
 }
 
+#if UUMPY_SPEC_CACHE_SIZE
+#if (UUMPY_SPEC_CACHE_SIZE & (UUMPY_SPEC_CACHE_SIZE - 1)) != 0
+#error UUMPY_SPEC_CACHE_SIZE must be a power of two
+#endif
+
+// Programs tend to apply the same few operations to the same few types over
+// and over again, so we keep a small direct-mapped cache of the specs that
+// the binary operators resolve to. The spec only depends on the operator
+// and the types so the key packs those into one word. Zero is never a
+// valid key since the typecodes are never zero.
+typedef struct _uumpy_spec_cache_entry {
+    uint32_t key;
+    char result_type;
+    uumpy_universal_spec spec;
+} uumpy_spec_cache_entry;
+
+static uumpy_spec_cache_entry ufunc_binary_spec_cache[UUMPY_SPEC_CACHE_SIZE];
+#endif
+
+void ufunc_find_binary_op_spec(uumpy_obj_ndarray_t *src1, uumpy_obj_ndarray_t *src2,
+                               char *dest_type_in_out, mp_binary_op_t op,
+                               uumpy_universal_spec *spec_out) {
+    #if UUMPY_SPEC_CACHE_SIZE
+    // Specs for 0-d arrays are never the fast ones so don't let them in
+    if (src1->dim_count > 0 && (mp_uint_t) op < 256) {
+        uint32_t key = ((uint32_t) op << 24) |
+                       ((uint32_t) (src1->typecode & 0xff) << 16) |
+                       ((uint32_t) (src2->typecode & 0xff) << 8) |
+                       (uint32_t) (*dest_type_in_out & 0xff);
+        uumpy_spec_cache_entry *entry = &ufunc_binary_spec_cache[(key ^ (key >> 11) ^ (key >> 19)) &
+                                                                  (UUMPY_SPEC_CACHE_SIZE - 1)];
+
+        if (entry->key != key) {
+            char result_type = *dest_type_in_out;
+            ufunc_resolve_binary_op_spec(src1, src2, &result_type, op, &entry->spec);
+            entry->result_type = result_type;
+            entry->key = key;
+        }
+
+        *dest_type_in_out = entry->result_type;
+        *spec_out = entry->spec;
+        return;
+    }
+    #endif
+
+    ufunc_resolve_binary_op_spec(src1, src2, dest_type_in_out, op, spec_out);
+}
+
 void ufunc_find_unary_op_spec(uumpy_obj_ndarray_t *src,
                               char *dest_type_in_out, mp_unary_op_t op,
                               uumpy_universal_spec *spec_out) {
@@ -351,6 +1842,7 @@ void ufunc_find_unary_op_spec(uumpy_obj_ndarray_t *src,
 
     uumpy_universal_spec spec = {
         .layers = 0,
+        .boxed = 1,
         .apply_fn.unary = &ufunc_universal_unary_op_fallback,
         .extra.u_op = op,
     };
@@ -362,7 +1854,12 @@ void ufunc_find_unary_float_func_spec(uumpy_obj_ndarray_t *src,
                                       char *dest_type_in_out, uumpy_unary_float_func f,
                                       uumpy_universal_spec *spec_out) {
     if (*dest_type_in_out == 0) {
+        #if UUMPY_SINGLE_KERNELS
+        // Float32 stays float32, as in numpy
+        *dest_type_in_out = (src->typecode == 'f') ? 'f' : UUMPY_DEFAULT_TYPE;
+        #else
         *dest_type_in_out = UUMPY_DEFAULT_TYPE;
+        #endif
     }
 
     if ((src->dim_count > 0) &&
@@ -375,9 +1872,34 @@ void ufunc_find_unary_float_func_spec(uumpy_obj_ndarray_t *src,
         };
 
         *spec_out = spec;
+    #if UUMPY_SINGLE_KERNELS
+    } else if ((src->dim_count > 0) &&
+               (src->typecode == 'f') &&
+               (*dest_type_in_out == 'f')) {
+        uumpy_universal_spec spec = {
+            .layers = 1,
+            .apply_fn.unary = &ufunc_unary_float_func_singles_1d,
+            .extra.f_func = f,
+        };
+
+        *spec_out = spec;
+    #endif
+    #if UUMPY_SPEEDUP_FLOAT
+    } else if ((src->dim_count > 0) &&
+               ufunc_is_numeric_type(src->typecode) &&
+               ufunc_is_float_type(*dest_type_in_out)) {
+        uumpy_universal_spec spec = {
+            .layers = 1,
+            .apply_fn.unary = &ufunc_unary_float_func_buffered,
+            .extra.f_func = f,
+        };
+
+        *spec_out = spec;
+    #endif
     } else {
         uumpy_universal_spec spec = {
             .layers = 0,
+            .boxed = 1,
             .apply_fn.unary = &ufunc_unary_float_func_fallback,
             .extra.f_func = f,
         };
@@ -392,6 +1914,11 @@ void ufunc_find_copy_spec(uumpy_obj_ndarray_t *src,
                           uumpy_universal_spec *spec_out) {
     char dest_type = dest ? dest->typecode : src->typecode;
 
+    // Without a destination the caller can ask for a type to convert to
+    if (!dest && dest_type_out && *dest_type_out) {
+        dest_type = *dest_type_out;
+    }
+
     if (dest_type_out) {
         *dest_type_out = dest_type;
     }
@@ -401,6 +1928,13 @@ void ufunc_find_copy_spec(uumpy_obj_ndarray_t *src,
 
         mp_int_t i = src->dim_count-1;
 
+        // New arrays are contiguous so there is no need to check the strides
+        if (src->simple && (!dest || dest->simple)) {
+            for (; i >= 0; i--) {
+                chunk_size *= src->dim_info[i].length;
+            }
+        }
+
         while((i >= 0) &&
               (src->dim_info[i].stride == chunk_size) &&
               (!dest || dest->dim_info[i].stride == chunk_size) ) {
@@ -416,10 +1950,23 @@ void ufunc_find_copy_spec(uumpy_obj_ndarray_t *src,
 
         copy_spec.value_size = mp_binary_get_size('@', dest_type, NULL),
 
+        *spec_out = copy_spec;
+    } else if ((src->dim_count > 0) &&
+               ufunc_is_numeric_type(src->typecode) &&
+               ufunc_is_numeric_type(dest_type) &&
+               ((UUMPY_SPEEDUP_FLOAT && (ufunc_is_float_type(src->typecode) || ufunc_is_float_type(dest_type))) ||
+                (UUMPY_SPEEDUP_INT && ufunc_is_small_int_type(src->typecode) && ufunc_is_small_int_type(dest_type)) ||
+                (UUMPY_SPEEDUP_INT64 && ufunc_is_int_type(src->typecode) && ufunc_is_int_type(dest_type)))) {
+        uumpy_universal_spec copy_spec = {
+            .layers = 1,
+            .apply_fn.unary = &ufunc_copy_buffered,
+        };
+
         *spec_out = copy_spec;
     } else {
         uumpy_universal_spec copy_spec = {
             .layers = 0,
+            .boxed = 1,
             .apply_fn.unary = &ufunc_copy_fallback,
         };
 
@@ -28,6 +28,9 @@
 
 struct _uumpy_universal_spec;
 
+// The most operands, including the output, that ufunc_apply_nary() handles
+#define UUMPY_MAX_OPERANDS (4)
+
 // A function that iterates across the last dimension to perform a function
 typedef bool(*uumpy_universal_binary)(size_t depth,
                                       uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
@@ -38,6 +41,11 @@ typedef bool(*uumpy_universal_unary)(size_t depth,
                                      uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
                                      uumpy_obj_ndarray_t *src, mp_int_t src_offset,
                                      struct _uumpy_universal_spec *spec);
+// A function that processes a run of count elements of an n-ary operation.
+// data points to the first element of each operand, output first, and
+// strides gives the stride of each operand in elements.
+typedef bool(*uumpy_universal_nary)(mp_int_t count, void **data, const mp_int_t *strides,
+                                    struct _uumpy_universal_spec *spec);
 
 typedef void(*uumpy_multiply_accumulate)(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
                                          uumpy_obj_ndarray_t *src1, mp_int_t src1_offset, mp_int_t src1_dim,
@@ -68,10 +76,12 @@ typedef mp_float_t(*uumpy_unary_float2_func)(mp_float_t x, mp_float_t y);
 typedef struct _uumpy_universal_spec {
     mp_int_t layers:8; // Number of dimensions unrolled in this function
     mp_int_t value_size:8; // Used for copy operations
-    mp_int_t _padding:16;
+    mp_int_t boxed:1; // Goes through Python objects, which may allocate
+    mp_int_t _padding:15;
     union {
         uumpy_universal_binary binary;
         uumpy_universal_unary unary;
+        uumpy_universal_nary nary;
     } apply_fn;
     union {
         mp_unary_op_t u_op;
@@ -95,6 +105,22 @@ bool ufunc_apply_binary(uumpy_obj_ndarray_t *dest,
                         uumpy_obj_ndarray_t *src2,
                         struct _uumpy_universal_spec *spec);
 
+bool ufunc_apply_nary(size_t op_count, uumpy_obj_ndarray_t **ops,
+                      uumpy_universal_spec *spec);
+
+mp_int_t ufunc_broadcast_shape(size_t op_count, uumpy_obj_ndarray_t **ops, mp_int_t *dims);
+
+// Storage for views made while resolving overlaps, normally on the stack
+typedef struct _uumpy_iteration_views {
+    uumpy_obj_ndarray_t arrays[UUMPY_MAX_OPERANDS];
+    uumpy_dim_info dim_info[UUMPY_MAX_OPERANDS][UUMPY_MAX_DIMS];
+} uumpy_iteration_views;
+
+bool ufunc_may_overlap(uumpy_obj_ndarray_t *a, uumpy_obj_ndarray_t *b);
+
+void ufunc_resolve_overlap(size_t op_count, uumpy_obj_ndarray_t **ops,
+                           uumpy_iteration_views *views);
+
 // Fallback for multiply-accumulate
 void ufunc_mul_acc_fallback(uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
                             uumpy_obj_ndarray_t *src1, mp_int_t src1_offset, mp_int_t src1_dim,
@@ -33,6 +33,16 @@
 #include "moduumpy.h"
 #include "ufunc.h"
 #include "uumath.h"
+#include "graph.h"
+
+static char uumpy_math_get_typecode(mp_obj_t dtype) {
+    size_t type_len;
+    const char *typecode_ptr = mp_obj_str_get_data(dtype, &type_len);
+    if (type_len != 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Data type should be a single character code"));
+    }
+    return typecode_ptr[0];
+}
 
 #define UUMATH_FUN_1(name) \
     static mp_obj_t uumpy_math_ ## name(size_t n_args, const mp_obj_t *args, mp_map_t *kwargs) { \
@@ -40,9 +50,62 @@
     } \
     MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_math_## name ## _obj, 1, uumpy_math_ ## name)
 
+// Apply a function, broadcasting the source into the destination if needed
+static mp_obj_t uumpy_math_apply(uumpy_obj_ndarray_t *dest, uumpy_obj_ndarray_t *src,
+                                 uumpy_universal_spec *spec) {
+    uumpy_broadcast bcast;
+    uumpy_obj_ndarray_t *dest_view = dest;
+
+    // Broadcast input if necessary. It's slower than expanding the result but uses less memory.
+    if (!ndarray_compare_dimensions(src, dest)) {
+        if (ndarray_broadcast_in_place(dest, src, &bcast)) {
+            mp_raise_ValueError(MP_ERROR_TEXT("non-broadcastable output operand"));
+        }
+        dest_view = &bcast.left;
+        src = &bcast.right;
+    }
+
+    uumpy_obj_ndarray_t *ops[2] = {dest_view, src};
+    uumpy_iteration_views overlap_views;
+
+    UUMPY_GRAPH_RECORD(2, ops, spec);
+
+    ufunc_resolve_overlap(2, ops, &overlap_views);
+
+    // Apply function
+    if (ufunc_apply_unary(ops[0], ops[1], spec)) {
+        return MP_OBJ_FROM_PTR(dest);
+    } else {
+        mp_raise_ValueError(MP_ERROR_TEXT("math error"));
+    }
+}
+
+static uumpy_obj_ndarray_t *uumpy_math_get_source(mp_obj_t x) {
+    // If the source is not an array then make one
+    if (!mp_obj_is_type(x, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+        return uumpy_array_from_value(x, UUMPY_DEFAULT_TYPE);
+    } else {
+        return MP_OBJ_TO_PTR(x);
+    }
+}
+
 static mp_obj_t uumpy_math_helper_1(uumpy_unary_float_func op_func,
                                     mp_uint_t n_args, const mp_obj_t *pos_args,
                                     mp_map_t *kw_args) {
+    uumpy_obj_ndarray_t *src;
+    uumpy_obj_ndarray_t *dest;
+    uumpy_universal_spec spec;
+    char result_typecode = 0;
+
+    // Calls with just an array are by far the most common, so don't parse them
+    if (n_args == 1 && (kw_args == NULL || kw_args->used == 0)) {
+        src = uumpy_math_get_source(pos_args[0]);
+        ufunc_find_unary_float_func_spec(src, &result_typecode, op_func, &spec);
+        dest = ndarray_new_shaped_like(result_typecode, src, 0);
+
+        return uumpy_math_apply(dest, src, &spec);
+    }
+
     enum {
         ARG_x,
         ARG_out,
@@ -57,31 +120,11 @@ static mp_obj_t uumpy_math_helper_1(uumpy_unary_float_func op_func,
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
-    uumpy_obj_ndarray_t *src;    
-    uumpy_obj_ndarray_t *dest;
-    uumpy_universal_spec spec;
-    char result_typecode = 0;
-    
-    // If the source is not an array then make one
-    if (!mp_obj_is_type(args[ARG_x].u_obj, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
-        src = uumpy_array_from_value(args[ARG_x].u_obj, UUMPY_DEFAULT_TYPE);
-    } else {
-        src = MP_OBJ_TO_PTR(args[ARG_x].u_obj);
-    }
+    src = uumpy_math_get_source(args[ARG_x].u_obj);
 
     if (args[ARG_out].u_obj == mp_const_none) {
         if (args[ARG_dtype].u_obj != mp_const_none) {
-            if (args[ARG_out].u_obj != mp_const_none) {
-                mp_raise_ValueError(MP_ERROR_TEXT("dtype and out arguments mutually exclusive"));
-            }
-            size_t type_len;
-            const char *typecode_ptr = mp_obj_str_get_data(args[ARG_dtype].u_obj, &type_len);
-            if (type_len != 1) {
-                mp_raise_ValueError(MP_ERROR_TEXT("Data type should be a single character code"));
-            }
-            result_typecode = typecode_ptr[0];
-        } else {
-            result_typecode = 0;
+            result_typecode = uumpy_math_get_typecode(args[ARG_dtype].u_obj);
         }
     } else {
         if (args[ARG_dtype].u_obj != mp_const_none) {
@@ -91,27 +134,14 @@ static mp_obj_t uumpy_math_helper_1(uumpy_unary_float_func op_func,
             result_typecode = dest->typecode;
         }
     }
-    
+
     ufunc_find_unary_float_func_spec(src, &result_typecode, op_func, &spec);
-    
+
     if (args[ARG_out].u_obj == mp_const_none) {
         dest = ndarray_new_shaped_like(result_typecode, src, 0);
-    } else {
-        dest = MP_OBJ_TO_PTR(&args[ARG_out]);
-        // Broadcast input if necessary. It's slower than expanding the result but uses less memory.
-        if (!ndarray_compare_dimensions(src, dest)) {
-            if (ndarray_broadcast(dest, src, &dest, &src)) {
-                mp_raise_ValueError(MP_ERROR_TEXT("non-broadcastable output operand"));
-            }
-        }
     }
 
-    // Apply function
-    if (ufunc_apply_unary(dest, src, &spec)) {
-        return MP_OBJ_FROM_PTR(dest);
-    } else {
-        mp_raise_ValueError(MP_ERROR_TEXT("math error"));
-    }
+    return uumpy_math_apply(dest, src, &spec);
 }
 
 UUMATH_FUN_1(sin);
@@ -133,3 +163,126 @@ UUMATH_FUN_1(atanh);
 UUMATH_FUN_1(exp);
 UUMATH_FUN_1(log);
 
+
+// A prepared operation binds a math function to its options so that repeated
+// calls skip the argument parsing. The spec is kept and only looked up again
+// when the type of the source changes, or when it changes between a 0-d
+// array and an array with dimensions, since only the latter get a kernel.
+typedef struct _uumpy_obj_prepared_t {
+    mp_obj_base_t base;
+    uumpy_unary_float_func op_func;
+    uumpy_obj_ndarray_t *out;
+    char dtype;
+    char src_typecode;
+    bool src_has_dims;
+    char result_typecode;
+    uumpy_universal_spec spec;
+} uumpy_obj_prepared_t;
+
+static const struct {
+    const void *fun;
+    uumpy_unary_float_func op_func;
+} uumpy_math_prepare_table[] = {
+    { &uumpy_math_sin_obj, MICROPY_FLOAT_C_FUN(sin) },
+    { &uumpy_math_cos_obj, MICROPY_FLOAT_C_FUN(cos) },
+    { &uumpy_math_tan_obj, MICROPY_FLOAT_C_FUN(tan) },
+    { &uumpy_math_asin_obj, MICROPY_FLOAT_C_FUN(asin) },
+    { &uumpy_math_acos_obj, MICROPY_FLOAT_C_FUN(acos) },
+    { &uumpy_math_atan_obj, MICROPY_FLOAT_C_FUN(atan) },
+#if UUMPY_ENABLE_HYPERBOLIC
+    { &uumpy_math_sinh_obj, MICROPY_FLOAT_C_FUN(sinh) },
+    { &uumpy_math_cosh_obj, MICROPY_FLOAT_C_FUN(cosh) },
+    { &uumpy_math_tanh_obj, MICROPY_FLOAT_C_FUN(tanh) },
+    { &uumpy_math_asinh_obj, MICROPY_FLOAT_C_FUN(asinh) },
+    { &uumpy_math_acosh_obj, MICROPY_FLOAT_C_FUN(acosh) },
+    { &uumpy_math_atanh_obj, MICROPY_FLOAT_C_FUN(atanh) },
+#endif
+    { &uumpy_math_exp_obj, MICROPY_FLOAT_C_FUN(exp) },
+    { &uumpy_math_log_obj, MICROPY_FLOAT_C_FUN(log) },
+};
+
+static mp_obj_t uumpy_math_prepared_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    uumpy_obj_prepared_t *self = MP_OBJ_TO_PTR(self_in);
+
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+
+    uumpy_obj_ndarray_t *src = uumpy_math_get_source(args[0]);
+
+    bool src_has_dims = (src->dim_count > 0);
+
+    if (src->typecode != self->src_typecode || src_has_dims != self->src_has_dims) {
+        char result_typecode = self->out ? self->out->typecode : self->dtype;
+
+        ufunc_find_unary_float_func_spec(src, &result_typecode, self->op_func, &self->spec);
+        self->src_typecode = src->typecode;
+        self->src_has_dims = src_has_dims;
+        self->result_typecode = result_typecode;
+    }
+
+    uumpy_obj_ndarray_t *dest = self->out;
+    if (dest == NULL) {
+        dest = ndarray_new_shaped_like(self->result_typecode, src, 0);
+    }
+
+    return uumpy_math_apply(dest, src, &self->spec);
+}
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    uumpy_math_type_prepared,
+    MP_QSTR_prepared,
+    MP_TYPE_FLAG_NONE,
+    call, uumpy_math_prepared_call
+);
+
+static mp_obj_t uumpy_math_prepare(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum {
+        ARG_func,
+        ARG_out,
+        ARG_dtype,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_func,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_out,     MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_dtype,   MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_unary_float_func op_func = NULL;
+
+    for (size_t i=0; i < MP_ARRAY_SIZE(uumpy_math_prepare_table); i++) {
+        if (uumpy_math_prepare_table[i].fun == MP_OBJ_TO_PTR(args[ARG_func].u_obj)) {
+            op_func = uumpy_math_prepare_table[i].op_func;
+            break;
+        }
+    }
+
+    if (op_func == NULL) {
+        mp_raise_TypeError(MP_ERROR_TEXT("function can not be prepared"));
+    }
+
+    uumpy_obj_prepared_t *self = uumpy_new_obj(uumpy_obj_prepared_t);
+    self->base.type = &uumpy_math_type_prepared;
+    self->op_func = op_func;
+    self->out = NULL;
+    self->dtype = 0;
+    self->src_typecode = 0;
+    self->src_has_dims = false;
+    self->result_typecode = 0;
+
+    if (args[ARG_out].u_obj != mp_const_none) {
+        if (args[ARG_dtype].u_obj != mp_const_none) {
+            mp_raise_ValueError(MP_ERROR_TEXT("dtype and out arguments mutually exclusive"));
+        }
+        if (!mp_obj_is_type(args[ARG_out].u_obj, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+            mp_raise_TypeError(MP_ERROR_TEXT("out must be an array"));
+        }
+        self->out = MP_OBJ_TO_PTR(args[ARG_out].u_obj);
+    } else if (args[ARG_dtype].u_obj != mp_const_none) {
+        self->dtype = uumpy_math_get_typecode(args[ARG_dtype].u_obj);
+    }
+
+    return MP_OBJ_FROM_PTR(self);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_math_prepare_obj, 1, uumpy_math_prepare);
@@ -44,3 +44,5 @@ MP_DECLARE_CONST_FUN_OBJ_KW(uumpy_math_atanh_obj);
 
 MP_DECLARE_CONST_FUN_OBJ_KW(uumpy_math_exp_obj);
 MP_DECLARE_CONST_FUN_OBJ_KW(uumpy_math_log_obj);
+
+MP_DECLARE_CONST_FUN_OBJ_KW(uumpy_math_prepare_obj);
@@ -47,11 +47,43 @@
 #define UUMPY_ENABLE_HYPERBOLIC (1)
 #define UUMPY_ENABLE_LINALG (1)
 #define UUMPY_ENABLE_FFT (1)
+#define UUMPY_ENABLE_SIGNAL (1)
+#define UUMPY_ENABLE_SPARSE (1)
 #define UUMPY_ENABLE_COMPLEX (1)
+#define UUMPY_ENABLE_GRAPH (1)
+// Support uumpy.noalloc() blocks, at the cost of a test on every allocation
+#define UUMPY_ENABLE_NOALLOC (1)
+
+// Limits
+// Maximum number of dimensions in an array. Many functions keep arrays of
+// this size on the stack so there is a small cost to making it larger.
+#define UUMPY_MAX_DIMS (8)
 
 // Time/space trade-off performance settings
 // Include float-specfic implementations
 #define UUMPY_SPEEDUP_FLOAT (1)
+// Include float32 implementations when the default type is double, so that
+// 'f' arrays are not widened element by element
+#define UUMPY_SPEEDUP_SINGLE (1)
 // Include regular integer-specfic implementations
 #define UUMPY_SPEEDUP_INT (1)
+// Include 64-bit integer implementations, used for 'q' and 'Q' arrays and
+// for mixes of integer types that don't fit in mp_int_t
+#define UUMPY_SPEEDUP_INT64 (1)
+// Include loops specialised for iterating over arrays of up to three dimensions
+#define UUMPY_SPEEDUP_RANK (1)
+// Alignment in bytes of the data of new arrays, a power of two. The GC
+// already aligns to MICROPY_BYTES_PER_GC_BLOCK (16 bytes on 32-bit ports,
+// 32 on 64-bit ones); a larger value costs a pointer in every array header
+// and some padding in every new array.
+#define UUMPY_DATA_ALIGNMENT (16)
+// Number of elements converted at a time when operands need casting. Each
+// kernel that casts keeps up to three buffers of this size on the stack.
+#define UUMPY_BUFFER_SIZE (64)
+// Number of entries in the cache of resolved binary operator specs. This
+// must be a power of two, or zero to disable the cache.
+#define UUMPY_SPEC_CACHE_SIZE (16)
+// Number of arrays given back by uumpy.release() or uumpy.scope() that are
+// kept for reuse by later arrays of the same size, or zero to disable.
+#define UUMPY_POOL_SIZE (8)
 
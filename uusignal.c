@@ -0,0 +1,2058 @@
+/*
+ * This file is part of the uumpy project
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Nicko van Someren
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// SPDX-License-Identifier: MIT
+
+#include <math.h>
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/binary.h"
+
+#include "moduumpy.h"
+#include "ufunc.h"
+#include "graph.h"
+#include "uusignal.h"
+
+#if UUMPY_ENABLE_SIGNAL
+
+#define SIN(x) MICROPY_FLOAT_C_FUN(sin)(x)
+#define COS(x) MICROPY_FLOAT_C_FUN(cos)(x)
+
+#define UUMPY_PI MICROPY_FLOAT_CONST(3.14159265358979323846)
+
+// Most of the signal functions work along a single axis of an n-D array.
+// We make a view with that axis at the end and then let the ufunc engine
+// iterate over all the other axes, calling a kernel that processes one
+// complete line at a time.
+
+// Get the input as an array of the default float type. If it already is
+// one then we use it as-is, so strided views don't get copied.
+static uumpy_obj_ndarray_t *_signal_float_array(mp_obj_t x_in) {
+    if (mp_obj_is_type(x_in, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+        uumpy_obj_ndarray_t *x = MP_OBJ_TO_PTR(x_in);
+        if (x->typecode == UUMPY_DEFAULT_TYPE) {
+            return x;
+        }
+    }
+    return uumpy_array_from_value(x_in, UUMPY_DEFAULT_TYPE);
+}
+
+static mp_int_t _signal_get_axis(uumpy_obj_ndarray_t *src, mp_obj_t axis_in) {
+    mp_int_t axis = mp_obj_get_int(axis_in);
+
+    if (axis < 0) {
+        axis += src->dim_count;
+    }
+    if (axis < 0 || axis >= src->dim_count) {
+        mp_raise_ValueError(MP_ERROR_TEXT("axis index out of range"));
+    }
+
+    return axis;
+}
+
+// Return a view of the array with one axis moved to a new position
+static uumpy_obj_ndarray_t *_signal_move_axis(uumpy_obj_ndarray_t *src, mp_int_t from, mp_int_t to) {
+    if (from == to) {
+        return src;
+    }
+
+    uumpy_dim_info new_dim_info[UUMPY_MAX_DIMS];
+    mp_int_t used = 0;
+
+    for (mp_int_t i=0; i < src->dim_count; i++) {
+        if (i == from) {
+            continue;
+        }
+        if (used == to) {
+            new_dim_info[used++] = src->dim_info[from];
+        }
+        new_dim_info[used++] = src->dim_info[i];
+    }
+    if (used == to) {
+        new_dim_info[used++] = src->dim_info[from];
+    }
+
+    return ndarray_new_view(src, src->base_offset, src->dim_count, new_dim_info);
+}
+
+// Apply a line kernel along an axis. The result is a new float array in
+// which that axis has been replaced by one of length out_length.
+static uumpy_obj_ndarray_t *_signal_apply_lines(uumpy_obj_ndarray_t *src, mp_int_t axis,
+                                                mp_int_t out_length,
+                                                uumpy_universal_unary kernel, void *context) {
+    mp_int_t last = src->dim_count - 1;
+    mp_int_t dims[UUMPY_MAX_DIMS];
+
+    src = _signal_move_axis(src, axis, last);
+
+    for (mp_int_t i=0; i < last; i++) {
+        dims[i] = src->dim_info[i].length;
+    }
+    dims[last] = out_length;
+
+    uumpy_obj_ndarray_t *dest = ndarray_new(UUMPY_DEFAULT_TYPE, src->dim_count, dims);
+
+    uumpy_universal_spec spec = {
+        .layers = 1,
+        .apply_fn.unary = kernel,
+        .context = context,
+    };
+
+    ufunc_apply_unary(dest, src, &spec);
+
+    return _signal_move_axis(dest, last, axis);
+}
+
+static mp_int_t _signal_gcd(mp_int_t a, mp_int_t b) {
+    while (b) {
+        mp_int_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Design a linear-phase low-pass FIR filter using a Hamming window. The
+// cutoff is relative to the Nyquist frequency and the taps are scaled to
+// give the requested gain at DC.
+static void _signal_firwin(mp_float_t *taps, mp_int_t tap_count,
+                           mp_float_t cutoff, mp_float_t gain) {
+    mp_float_t centre = (tap_count - 1) / MICROPY_FLOAT_CONST(2.0);
+    mp_float_t sum = 0;
+
+    for (mp_int_t n=0; n < tap_count; n++) {
+        mp_float_t m = n - centre;
+        mp_float_t v = (m == 0) ? cutoff : SIN(UUMPY_PI * cutoff * m) / (UUMPY_PI * m);
+
+        if (tap_count > 1) {
+            v *= MICROPY_FLOAT_CONST(0.54) -
+                MICROPY_FLOAT_CONST(0.46) * COS(2 * UUMPY_PI * n / (tap_count - 1));
+        }
+        taps[n] = v;
+        sum += v;
+    }
+
+    gain /= sum;
+    for (mp_int_t n=0; n < tap_count; n++) {
+        taps[n] *= gain;
+    }
+}
+
+// A polyphase filter computes the result of upsampling by inserting zeros,
+// FIR filtering and then downsampling. Only the output samples that are
+// kept are computed and for each of those only the taps that line up with
+// real (non-zero) input samples are used.
+typedef struct _uumpy_signal_polyphase {
+    mp_float_t *taps;
+    mp_int_t tap_count;
+    mp_int_t up;
+    mp_int_t down;
+    // Position of the next output sample in the upsampled stream
+    mp_int_t position;
+} uumpy_signal_polyphase;
+
+static void _signal_polyphase_init(uumpy_signal_polyphase *pp, mp_int_t up, mp_int_t down,
+                                   mp_obj_t window_in) {
+    if (up < 1 || down < 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("up and down must be >= 1"));
+    }
+
+    mp_int_t g = _signal_gcd(up, down);
+    pp->up = up / g;
+    pp->down = down / g;
+
+    if (window_in == mp_const_none) {
+        mp_int_t max_rate = MAX(pp->up, pp->down);
+        pp->tap_count = 20 * max_rate + 1;
+        pp->taps = uumpy_new(mp_float_t, pp->tap_count);
+        _signal_firwin(pp->taps, pp->tap_count, MICROPY_FLOAT_CONST(1.0) / max_rate, pp->up);
+    } else {
+        uumpy_obj_ndarray_t *w = _signal_float_array(window_in);
+        if (w->dim_count != 1 || w->dim_info[0].length == 0) {
+            mp_raise_ValueError(MP_ERROR_TEXT("window must be a non-empty 1-D array"));
+        }
+        pp->tap_count = w->dim_info[0].length;
+        pp->taps = uumpy_new(mp_float_t, pp->tap_count);
+
+        mp_float_t *w_data = (mp_float_t *) w->data;
+        for (mp_int_t i=0; i < pp->tap_count; i++) {
+            pp->taps[i] = w_data[w->base_offset + i * w->dim_info[0].stride] * pp->up;
+        }
+    }
+
+    // Compensate for the delay of the filter
+    pp->position = (pp->tap_count - 1) / 2;
+}
+
+static bool _signal_polyphase_line(size_t depth,
+                                   uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                   uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                   struct _uumpy_universal_spec *spec) {
+    uumpy_signal_polyphase *pp = spec->context;
+    mp_float_t *src_data = (mp_float_t *) src->data;
+    mp_float_t *dest_data = (mp_float_t *) dest->data;
+    mp_int_t src_stride = src->dim_info[depth].stride;
+    mp_int_t src_length = src->dim_info[depth].length;
+    mp_int_t dest_stride = dest->dim_info[depth].stride;
+    mp_int_t up = pp->up;
+    mp_int_t t = pp->position;
+
+    for (mp_int_t k = dest->dim_info[depth].length; k > 0; k--) {
+        mp_int_t n = t / up;
+        mp_int_t j = t - n * up;
+        mp_float_t acc = 0;
+
+        // Skip taps that fall beyond the end of the input
+        if (n >= src_length) {
+            j += (n - (src_length - 1)) * up;
+            n = src_length - 1;
+        }
+
+        mp_int_t x_index = src_offset + n * src_stride;
+        for (; j < pp->tap_count && n >= 0; j += up, n--) {
+            acc += pp->taps[j] * src_data[x_index];
+            x_index -= src_stride;
+        }
+
+        dest_data[dest_offset] = acc;
+        dest_offset += dest_stride;
+        t += pp->down;
+    }
+
+    return true;
+}
+
+static mp_obj_t _signal_resample_poly_impl(mp_obj_t x_in, mp_obj_t axis_in,
+                                           uumpy_signal_polyphase *pp) {
+    uumpy_obj_ndarray_t *x = _signal_float_array(x_in);
+
+    if (x->dim_count == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("input must have at least one dimension"));
+    }
+
+    mp_int_t axis = _signal_get_axis(x, axis_in);
+
+    if (pp->up == 1 && pp->down == 1) {
+        return MP_OBJ_FROM_PTR(ndarray_new_from_ndarray(MP_OBJ_FROM_PTR(x), UUMPY_DEFAULT_TYPE));
+    }
+
+    mp_int_t n_in = x->dim_info[axis].length;
+    mp_int_t n_out = (n_in * pp->up + pp->down - 1) / pp->down;
+
+    return MP_OBJ_FROM_PTR(_signal_apply_lines(x, axis, n_out, _signal_polyphase_line, pp));
+}
+
+static mp_obj_t uumpy_signal_resample_poly(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_x,
+        ARG_up,
+        ARG_down,
+        ARG_axis,
+        ARG_window,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_x,      MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_up,     MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 1} },
+        { MP_QSTR_down,   MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 1} },
+        { MP_QSTR_axis,   MP_ARG_OBJ,                   {.u_obj = MP_OBJ_NEW_SMALL_INT(0)} },
+        { MP_QSTR_window, MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_signal_polyphase pp;
+    _signal_polyphase_init(&pp, args[ARG_up].u_int, args[ARG_down].u_int, args[ARG_window].u_obj);
+
+    return _signal_resample_poly_impl(args[ARG_x].u_obj, args[ARG_axis].u_obj, &pp);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_resample_poly_obj, 3, uumpy_signal_resample_poly);
+
+// Downsample after applying an anti-aliasing FIR filter of order n
+static mp_obj_t uumpy_signal_decimate(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_x,
+        ARG_q,
+        ARG_n,
+        ARG_axis,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_x,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_q,    MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 1} },
+        { MP_QSTR_n,    MP_ARG_OBJ,                   {.u_obj = mp_const_none} },
+        { MP_QSTR_axis, MP_ARG_OBJ,                   {.u_obj = MP_OBJ_NEW_SMALL_INT(-1)} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_int_t q = args[ARG_q].u_int;
+    if (q < 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("q must be >= 1"));
+    }
+
+    mp_int_t order = (args[ARG_n].u_obj == mp_const_none) ? 20 * q : mp_obj_get_int(args[ARG_n].u_obj);
+    if (order < 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("filter order must be >= 0"));
+    }
+
+    uumpy_signal_polyphase pp = {
+        .tap_count = order + 1,
+        .up = 1,
+        .down = q,
+        .position = order / 2,
+    };
+    pp.taps = uumpy_new(mp_float_t, pp.tap_count);
+    _signal_firwin(pp.taps, pp.tap_count, MICROPY_FLOAT_CONST(1.0) / q, 1);
+
+    return _signal_resample_poly_impl(args[ARG_x].u_obj, args[ARG_axis].u_obj, &pp);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_decimate_obj, 2, uumpy_signal_decimate);
+
+// A streaming polyphase resampler. Input arrives in blocks of any length
+// and the tail of each block is kept as history for the next one. Unlike
+// resample_poly() this is causal, so the output is delayed by half the
+// length of the filter.
+typedef struct _uumpy_signal_obj_resampler_t {
+    mp_obj_base_t base;
+    uumpy_signal_polyphase pp;
+    mp_int_t history_length;
+    mp_float_t *history;
+} uumpy_signal_obj_resampler_t;
+
+static mp_obj_t uumpy_signal_resampler_make_new(const mp_obj_type_t *type_in, size_t n_args,
+                                                size_t n_kw, const mp_obj_t *all_args) {
+    enum {
+        ARG_up,
+        ARG_down,
+        ARG_window,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_up,     MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 1} },
+        { MP_QSTR_down,   MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 1} },
+        { MP_QSTR_window, MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, all_args + n_args);
+    mp_arg_parse_all(n_args, all_args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_signal_obj_resampler_t *o = uumpy_new_obj(uumpy_signal_obj_resampler_t);
+    o->base.type = type_in;
+
+    _signal_polyphase_init(&o->pp, args[ARG_up].u_int, args[ARG_down].u_int, args[ARG_window].u_obj);
+    o->pp.position = 0;
+
+    // Enough input history to cover every tap of any phase
+    o->history_length = (o->pp.tap_count + o->pp.up - 1) / o->pp.up;
+    o->history = uumpy_new(mp_float_t, o->history_length);
+    memset(o->history, 0, o->history_length * sizeof(mp_float_t));
+
+    return MP_OBJ_FROM_PTR(o);
+}
+
+// Process a block of samples. If an output array is given then the result
+// is written to the start of it and the number of samples written is
+// returned, otherwise a new array of the right length is returned.
+static mp_obj_t uumpy_signal_resampler_process(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_self,
+        ARG_x,
+        ARG_out,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_self, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_x,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_out,  MP_ARG_OBJ,                   {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_signal_obj_resampler_t *self = MP_OBJ_TO_PTR(args[ARG_self].u_obj);
+    uumpy_signal_polyphase *pp = &self->pp;
+    uumpy_obj_ndarray_t *x = _signal_float_array(args[ARG_x].u_obj);
+
+    if (x->dim_count != 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("input must be a 1-D array"));
+    }
+
+    mp_float_t *x_data = (mp_float_t *) x->data;
+    mp_int_t x_stride = x->dim_info[0].stride;
+    mp_int_t n_in = x->dim_info[0].length;
+    mp_int_t total = n_in * pp->up;
+    mp_int_t count = (pp->position < total) ? (total - pp->position + pp->down - 1) / pp->down : 0;
+    uumpy_obj_ndarray_t *dest;
+
+    if (args[ARG_out].u_obj == mp_const_none) {
+        dest = ndarray_new(UUMPY_DEFAULT_TYPE, 1, &count);
+    } else {
+        dest = MP_OBJ_TO_PTR(args[ARG_out].u_obj);
+        if (!mp_obj_is_type(args[ARG_out].u_obj, MP_OBJ_FROM_PTR(&uumpy_type_ndarray)) ||
+            dest->typecode != UUMPY_DEFAULT_TYPE || dest->dim_count != 1) {
+            mp_raise_TypeError(MP_ERROR_TEXT("out must be a 1-D float array"));
+        }
+        if (dest->dim_info[0].length < count) {
+            mp_raise_ValueError(MP_ERROR_TEXT("out is too short"));
+        }
+    }
+
+    mp_float_t *dest_data = (mp_float_t *) dest->data;
+    mp_int_t dest_offset = dest->base_offset;
+
+    for (mp_int_t k=0; k < count; k++) {
+        mp_int_t n = pp->position / pp->up;
+        mp_int_t j = pp->position - n * pp->up;
+        mp_float_t acc = 0;
+
+        // Negative input indices refer to the history from earlier blocks
+        for (; j < pp->tap_count; j += pp->up, n--) {
+            mp_float_t v = (n >= 0) ? x_data[x->base_offset + n * x_stride] : self->history[self->history_length + n];
+            acc += pp->taps[j] * v;
+        }
+
+        dest_data[dest_offset] = acc;
+        dest_offset += dest->dim_info[0].stride;
+        pp->position += pp->down;
+    }
+
+    pp->position -= total;
+
+    // Keep the tail of the input for the next block
+    mp_int_t keep = MIN(n_in, self->history_length);
+    mp_int_t shift = self->history_length - keep;
+    if (shift) {
+        memmove(self->history, self->history + keep, shift * sizeof(mp_float_t));
+    }
+    for (mp_int_t i=0; i < keep; i++) {
+        self->history[shift + i] = x_data[x->base_offset + (n_in - keep + i) * x_stride];
+    }
+
+    if (args[ARG_out].u_obj == mp_const_none) {
+        return MP_OBJ_FROM_PTR(dest);
+    } else {
+        return MP_OBJ_NEW_SMALL_INT(count);
+    }
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_resampler_process_obj, 2, uumpy_signal_resampler_process);
+
+static mp_obj_t uumpy_signal_resampler_reset(mp_obj_t self_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_signal_obj_resampler_t *self = MP_OBJ_TO_PTR(self_in);
+
+    self->pp.position = 0;
+    memset(self->history, 0, self->history_length * sizeof(mp_float_t));
+
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_signal_resampler_reset_obj, uumpy_signal_resampler_reset);
+
+static const mp_rom_map_elem_t uumpy_signal_resampler_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_process), MP_ROM_PTR(&uumpy_signal_resampler_process_obj) },
+    { MP_ROM_QSTR(MP_QSTR_reset), MP_ROM_PTR(&uumpy_signal_resampler_reset_obj) },
+};
+static MP_DEFINE_CONST_DICT(uumpy_signal_resampler_locals_dict, uumpy_signal_resampler_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    uumpy_signal_type_Resampler,
+    MP_QSTR_Resampler,
+    MP_TYPE_FLAG_NONE,
+    make_new, uumpy_signal_resampler_make_new,
+    locals_dict, &uumpy_signal_resampler_locals_dict
+);
+
+// Boundary handling for filters that read beyond the edges of the input
+#define UUMPY_SIGNAL_BOUNDARY_FILL (0)
+#define UUMPY_SIGNAL_BOUNDARY_WRAP (1)
+#define UUMPY_SIGNAL_BOUNDARY_SYMM (2)
+#define UUMPY_SIGNAL_BOUNDARY_NEAREST (3)
+#define UUMPY_SIGNAL_BOUNDARY_MIRROR (4)
+
+typedef struct _uumpy_signal_boundary {
+    int mode;
+    mp_float_t fill_value;
+} uumpy_signal_boundary;
+
+static int _signal_get_boundary_mode(mp_obj_t boundary_in) {
+    const char *boundary = mp_obj_str_get_str(boundary_in);
+
+    if (strcmp(boundary, "fill") == 0) {
+        return UUMPY_SIGNAL_BOUNDARY_FILL;
+    } else if (strcmp(boundary, "wrap") == 0) {
+        return UUMPY_SIGNAL_BOUNDARY_WRAP;
+    } else if (strcmp(boundary, "symm") == 0) {
+        return UUMPY_SIGNAL_BOUNDARY_SYMM;
+    } else {
+        mp_raise_ValueError(MP_ERROR_TEXT("boundary must be 'fill', 'wrap' or 'symm'"));
+    }
+}
+
+// Map an index that may lie outside [0, length) back into the input.
+// Returns -1 if the fill value should be used instead.
+static mp_int_t _signal_boundary_index(mp_int_t i, mp_int_t length, int mode) {
+    if (i >= 0 && i < length) {
+        return i;
+    }
+
+    switch (mode) {
+    case UUMPY_SIGNAL_BOUNDARY_WRAP:
+        i %= length;
+        return (i < 0) ? i + length : i;
+
+    case UUMPY_SIGNAL_BOUNDARY_SYMM:
+        i %= 2 * length;
+        if (i < 0) {
+            i += 2 * length;
+        }
+        return (i < length) ? i : (2 * length - 1) - i;
+
+    case UUMPY_SIGNAL_BOUNDARY_NEAREST:
+        return (i < 0) ? 0 : length - 1;
+
+    case UUMPY_SIGNAL_BOUNDARY_MIRROR:
+        if (length == 1) {
+            return 0;
+        }
+        i %= 2 * length - 2;
+        if (i < 0) {
+            i += 2 * length - 2;
+        }
+        return (i < length) ? i : (2 * length - 2) - i;
+
+    default:
+        return -1;
+    }
+}
+
+// Correlate a line of the input with a set of taps, adding the result into
+// the destination: dest[j] += sum(taps[n] * src[start + j + n]). Only the
+// ends of the line, where taps fall outside the input, pay for boundary
+// handling.
+static void _signal_correlate_1d(mp_float_t *dest, mp_int_t dest_stride, mp_int_t count,
+                                 const mp_float_t *src, mp_int_t src_stride, mp_int_t src_length,
+                                 const mp_float_t *taps, mp_int_t tap_stride, mp_int_t tap_count,
+                                 mp_int_t start, uumpy_signal_boundary *boundary) {
+    mp_int_t lo = MIN(MAX(-start, 0), count);
+    mp_int_t hi = MIN(MAX(src_length - tap_count + 1 - start, lo), count);
+
+    for (mp_int_t j=0; j < count; j++) {
+        mp_float_t acc = 0;
+
+        if (j >= lo && j < hi) {
+            const mp_float_t *s = src + (start + j) * src_stride;
+            const mp_float_t *t = taps;
+            for (mp_int_t n = tap_count; n > 0; n--) {
+                acc += *t * *s;
+                s += src_stride;
+                t += tap_stride;
+            }
+        } else {
+            for (mp_int_t n=0; n < tap_count; n++) {
+                mp_int_t i = _signal_boundary_index(start + j + n, src_length, boundary->mode);
+                mp_float_t v = (i < 0) ? boundary->fill_value : src[i * src_stride];
+                acc += taps[n * tap_stride] * v;
+            }
+        }
+
+        dest[j * dest_stride] += acc;
+    }
+}
+
+// If the kernel is the outer product of a column and a row then find them
+static bool _signal_kernel_separate(uumpy_obj_ndarray_t *k, mp_float_t *col, mp_float_t *row) {
+    mp_float_t *k_data = ((mp_float_t *) k->data) + k->base_offset;
+    mp_int_t kh = k->dim_info[0].length;
+    mp_int_t kw = k->dim_info[1].length;
+    mp_int_t rs = k->dim_info[0].stride;
+    mp_int_t cs = k->dim_info[1].stride;
+    mp_int_t pr = 0, pc = 0;
+    mp_float_t max_abs = 0;
+
+    for (mp_int_t m=0; m < kh; m++) {
+        for (mp_int_t n=0; n < kw; n++) {
+            mp_float_t v = MICROPY_FLOAT_C_FUN(fabs)(k_data[m * rs + n * cs]);
+            if (v > max_abs) {
+                max_abs = v;
+                pr = m;
+                pc = n;
+            }
+        }
+    }
+
+    if (max_abs == 0) {
+        return false;
+    }
+
+    mp_float_t pivot = k_data[pr * rs + pc * cs];
+    for (mp_int_t m=0; m < kh; m++) {
+        col[m] = k_data[m * rs + pc * cs];
+    }
+    for (mp_int_t n=0; n < kw; n++) {
+        row[n] = k_data[pr * rs + n * cs] / pivot;
+    }
+
+    mp_float_t tolerance = 4 * UUMPY_EPSILON * max_abs;
+    for (mp_int_t m=0; m < kh; m++) {
+        for (mp_int_t n=0; n < kw; n++) {
+            if (MICROPY_FLOAT_C_FUN(fabs)(k_data[m * rs + n * cs] - col[m] * row[n]) > tolerance) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Correlate a 2-D input with a 2-D kernel into a new contiguous array:
+// dest[i, j] = sum(k[m, n] * a[i + start_r + m, j + start_c + n]).
+// Rank-1 kernels are applied as a pass along the rows followed by a pass
+// down the columns.
+static void _signal_correlate_2d(uumpy_obj_ndarray_t *dest, uumpy_obj_ndarray_t *a,
+                                 uumpy_obj_ndarray_t *k, mp_int_t start_r, mp_int_t start_c,
+                                 uumpy_signal_boundary *boundary) {
+    mp_float_t *dest_data = (mp_float_t *) dest->data;
+    mp_float_t *a_data = ((mp_float_t *) a->data) + a->base_offset;
+    mp_float_t *k_data = ((mp_float_t *) k->data) + k->base_offset;
+    mp_int_t out_h = dest->dim_info[0].length;
+    mp_int_t out_w = dest->dim_info[1].length;
+    mp_int_t a_h = a->dim_info[0].length;
+    mp_int_t a_w = a->dim_info[1].length;
+    mp_int_t a_rs = a->dim_info[0].stride;
+    mp_int_t a_cs = a->dim_info[1].stride;
+    mp_int_t kh = k->dim_info[0].length;
+    mp_int_t kw = k->dim_info[1].length;
+
+    memset(dest_data, 0, out_h * out_w * sizeof(mp_float_t));
+
+    if (kh > 1 && kw > 1) {
+        mp_float_t *col = uumpy_new(mp_float_t, kh + kw);
+        mp_float_t *row = col + kh;
+
+        if (_signal_kernel_separate(k, col, row)) {
+            // Filter every input row that we need along its length first
+            mp_int_t temp_h = out_h + kh - 1;
+            mp_float_t *temp = uumpy_new(mp_float_t, temp_h * out_w);
+            mp_float_t row_sum = 0;
+
+            for (mp_int_t n=0; n < kw; n++) {
+                row_sum += row[n];
+            }
+
+            for (mp_int_t r=0; r < temp_h; r++) {
+                mp_float_t *t_row = temp + r * out_w;
+                mp_int_t i = _signal_boundary_index(start_r + r, a_h, boundary->mode);
+
+                if (i < 0) {
+                    for (mp_int_t j=0; j < out_w; j++) {
+                        t_row[j] = boundary->fill_value * row_sum;
+                    }
+                } else {
+                    memset(t_row, 0, out_w * sizeof(mp_float_t));
+                    _signal_correlate_1d(t_row, 1, out_w,
+                                         a_data + i * a_rs, a_cs, a_w,
+                                         row, 1, kw, start_c, boundary);
+                }
+            }
+
+            // Then filter down the columns, which no longer need boundary handling
+            for (mp_int_t j=0; j < out_w; j++) {
+                _signal_correlate_1d(dest_data + j, out_w, out_h,
+                                     temp + j, out_w, temp_h,
+                                     col, 1, kh, 0, boundary);
+            }
+
+            m_del(mp_float_t, temp, temp_h * out_w);
+            m_del(mp_float_t, col, kh + kw);
+            return;
+        }
+
+        m_del(mp_float_t, col, kh + kw);
+    }
+
+    // Accumulate the correlation of each kernel row with the matching input row
+    for (mp_int_t i=0; i < out_h; i++) {
+        mp_float_t *d_row = dest_data + i * out_w;
+
+        for (mp_int_t m=0; m < kh; m++) {
+            mp_float_t *k_row = k_data + m * k->dim_info[0].stride;
+            mp_int_t r = _signal_boundary_index(start_r + i + m, a_h, boundary->mode);
+
+            if (r < 0) {
+                mp_float_t k_sum = 0;
+                for (mp_int_t n=0; n < kw; n++) {
+                    k_sum += k_row[n * k->dim_info[1].stride];
+                }
+                for (mp_int_t j=0; j < out_w; j++) {
+                    d_row[j] += boundary->fill_value * k_sum;
+                }
+            } else {
+                _signal_correlate_1d(d_row, 1, out_w,
+                                     a_data + r * a_rs, a_cs, a_w,
+                                     k_row, k->dim_info[1].stride, kw, start_c, boundary);
+            }
+        }
+    }
+}
+
+#define UUMPY_SIGNAL_MODE_FULL (0)
+#define UUMPY_SIGNAL_MODE_SAME (1)
+#define UUMPY_SIGNAL_MODE_VALID (2)
+
+static mp_obj_t _signal_convolve2d_helper(bool flip, size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_in1,
+        ARG_in2,
+        ARG_mode,
+        ARG_boundary,
+        ARG_fillvalue,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_in1,       MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_in2,       MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_mode,      MP_ARG_OBJ,                   {.u_obj = MP_OBJ_NEW_QSTR(MP_QSTR_full)} },
+        { MP_QSTR_boundary,  MP_ARG_OBJ,                   {.u_obj = MP_OBJ_NEW_QSTR(MP_QSTR_fill)} },
+        { MP_QSTR_fillvalue, MP_ARG_OBJ,                   {.u_obj = MP_OBJ_NEW_SMALL_INT(0)} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_obj_ndarray_t *a = _signal_float_array(args[ARG_in1].u_obj);
+    uumpy_obj_ndarray_t *k = _signal_float_array(args[ARG_in2].u_obj);
+
+    if (a->dim_count != 2 || k->dim_count != 2) {
+        mp_raise_ValueError(MP_ERROR_TEXT("inputs must both be 2-D arrays"));
+    }
+
+    const char *mode_str = mp_obj_str_get_str(args[ARG_mode].u_obj);
+    int mode;
+    if (strcmp(mode_str, "full") == 0) {
+        mode = UUMPY_SIGNAL_MODE_FULL;
+    } else if (strcmp(mode_str, "same") == 0) {
+        mode = UUMPY_SIGNAL_MODE_SAME;
+    } else if (strcmp(mode_str, "valid") == 0) {
+        mode = UUMPY_SIGNAL_MODE_VALID;
+    } else {
+        mp_raise_ValueError(MP_ERROR_TEXT("mode must be 'full', 'same' or 'valid'"));
+    }
+
+    uumpy_signal_boundary boundary = {
+        .mode = _signal_get_boundary_mode(args[ARG_boundary].u_obj),
+        .fill_value = mp_obj_get_float(args[ARG_fillvalue].u_obj),
+    };
+
+    mp_int_t a_h = a->dim_info[0].length;
+    mp_int_t a_w = a->dim_info[1].length;
+    mp_int_t kh = k->dim_info[0].length;
+    mp_int_t kw = k->dim_info[1].length;
+
+    if (a_h == 0 || a_w == 0 || kh == 0 || kw == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("inputs must not be empty"));
+    }
+
+    // Convolution is correlation with the kernel rotated by 180 degrees,
+    // which we get as a view with negated strides.
+    if (flip) {
+        uumpy_dim_info flipped[2];
+        flipped[0].length = kh;
+        flipped[0].stride = -k->dim_info[0].stride;
+        flipped[1].length = kw;
+        flipped[1].stride = -k->dim_info[1].stride;
+        k = ndarray_new_view(k, k->base_offset + (kh - 1) * k->dim_info[0].stride + (kw - 1) * k->dim_info[1].stride,
+                             2, flipped);
+    }
+
+    // Work out where the output sits relative to the 'full' result
+    mp_int_t dims[2];
+    mp_int_t start_r, start_c;
+
+    switch (mode) {
+    case UUMPY_SIGNAL_MODE_SAME:
+        dims[0] = a_h;
+        dims[1] = a_w;
+        start_r = (kh - 1) / 2;
+        start_c = (kw - 1) / 2;
+        break;
+    case UUMPY_SIGNAL_MODE_VALID:
+        if (kh > a_h || kw > a_w) {
+            mp_raise_ValueError(MP_ERROR_TEXT("kernel must not be larger than the input in 'valid' mode"));
+        }
+        dims[0] = a_h - kh + 1;
+        dims[1] = a_w - kw + 1;
+        start_r = kh - 1;
+        start_c = kw - 1;
+        break;
+    default:
+        dims[0] = a_h + kh - 1;
+        dims[1] = a_w + kw - 1;
+        start_r = 0;
+        start_c = 0;
+        break;
+    }
+
+    uumpy_obj_ndarray_t *dest = ndarray_new(UUMPY_DEFAULT_TYPE, 2, dims);
+    _signal_correlate_2d(dest, a, k, start_r - (kh - 1), start_c - (kw - 1), &boundary);
+
+    return MP_OBJ_FROM_PTR(dest);
+}
+
+static mp_obj_t uumpy_signal_convolve2d(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    return _signal_convolve2d_helper(true, n_args, pos_args, kw_args);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_convolve2d_obj, 2, uumpy_signal_convolve2d);
+
+static mp_obj_t uumpy_signal_correlate2d(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    return _signal_convolve2d_helper(false, n_args, pos_args, kw_args);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_correlate2d_obj, 2, uumpy_signal_correlate2d);
+
+
+// Rank and uniform filters, with the same arguments as their counterparts
+// in scipy.ndimage. Minimum, maximum and uniform filters are separable so
+// they are applied as a pass along the rows and then one down the columns.
+
+#define UUMPY_SIGNAL_FILTER_MAX (0)
+#define UUMPY_SIGNAL_FILTER_MIN (1)
+#define UUMPY_SIGNAL_FILTER_UNIFORM (2)
+#define UUMPY_SIGNAL_FILTER_MEDIAN (3)
+
+// ndimage uses different names for the boundary modes
+static int _signal_get_filter_mode(mp_obj_t mode_in) {
+    const char *mode = mp_obj_str_get_str(mode_in);
+
+    if (strcmp(mode, "reflect") == 0) {
+        return UUMPY_SIGNAL_BOUNDARY_SYMM;
+    } else if (strcmp(mode, "constant") == 0) {
+        return UUMPY_SIGNAL_BOUNDARY_FILL;
+    } else if (strcmp(mode, "nearest") == 0) {
+        return UUMPY_SIGNAL_BOUNDARY_NEAREST;
+    } else if (strcmp(mode, "mirror") == 0) {
+        return UUMPY_SIGNAL_BOUNDARY_MIRROR;
+    } else if (strcmp(mode, "wrap") == 0) {
+        return UUMPY_SIGNAL_BOUNDARY_WRAP;
+    } else {
+        mp_raise_ValueError(MP_ERROR_TEXT("unsupported filter mode"));
+    }
+}
+
+// Copy a line into a work buffer, extended at both ends so that every
+// window of the given size that is centred on the line is available
+static void _signal_extend_line(mp_float_t *ext, const mp_float_t *src, mp_int_t src_stride,
+                                mp_int_t length, mp_int_t size, uumpy_signal_boundary *boundary) {
+    mp_int_t start = -(size / 2);
+
+    for (mp_int_t t=0; t < length + size - 1; t++) {
+        mp_int_t i = _signal_boundary_index(start + t, length, boundary->mode);
+        ext[t] = (i < 0) ? boundary->fill_value : src[i * src_stride];
+    }
+}
+
+// The van Herk/Gil-Werman algorithm finds the max (or min) over a sliding
+// window with about three comparisons per sample, whatever the window size.
+// The extended line is split into blocks of the window size and we take
+// running maxima forwards and backwards within each block; every window
+// then spans at most two blocks.
+static void _signal_minmax_1d(mp_float_t *dest, mp_int_t dest_stride,
+                              const mp_float_t *src, mp_int_t src_stride, mp_int_t length,
+                              mp_int_t size, bool is_max, uumpy_signal_boundary *boundary,
+                              mp_float_t *work) {
+    mp_int_t ext_length = length + size - 1;
+    mp_float_t *h = work;
+    mp_float_t *g = work + ext_length;
+
+    _signal_extend_line(h, src, src_stride, length, size, boundary);
+
+    for (mp_int_t t=0; t < ext_length; t++) {
+        if (t % size == 0) {
+            g[t] = h[t];
+        } else {
+            g[t] = ((h[t] > g[t-1]) == is_max) ? h[t] : g[t-1];
+        }
+    }
+
+    // The backward maxima can overwrite the extended line as we go
+    for (mp_int_t t = ext_length - 2; t >= 0; t--) {
+        if ((t + 1) % size != 0) {
+            if ((h[t+1] > h[t]) == is_max) {
+                h[t] = h[t+1];
+            }
+        }
+    }
+
+    for (mp_int_t i=0; i < length; i++) {
+        mp_float_t a = h[i];
+        mp_float_t b = g[i + size - 1];
+        dest[i * dest_stride] = ((a > b) == is_max) ? a : b;
+    }
+}
+
+// A running sum gives the mean over a sliding window in constant time
+static void _signal_uniform_1d(mp_float_t *dest, mp_int_t dest_stride,
+                               const mp_float_t *src, mp_int_t src_stride, mp_int_t length,
+                               mp_int_t size, uumpy_signal_boundary *boundary,
+                               mp_float_t *work) {
+    mp_float_t sum = 0;
+    mp_float_t scale = MICROPY_FLOAT_CONST(1.0) / size;
+
+    _signal_extend_line(work, src, src_stride, length, size, boundary);
+
+    for (mp_int_t t=0; t < size; t++) {
+        sum += work[t];
+    }
+
+    for (mp_int_t i=0; i < length; i++) {
+        dest[i * dest_stride] = sum * scale;
+        if (i + 1 < length) {
+            sum += work[i + size] - work[i];
+        }
+    }
+}
+
+// Median of a 2-D window, by partial sorting of the gathered values
+static void _signal_median_float(uumpy_obj_ndarray_t *dest, uumpy_obj_ndarray_t *a,
+                                 mp_int_t kh, mp_int_t kw, uumpy_signal_boundary *boundary) {
+    mp_float_t *a_data = ((mp_float_t *) a->data) + a->base_offset;
+    mp_float_t *dest_data = (mp_float_t *) dest->data;
+    mp_int_t a_h = a->dim_info[0].length;
+    mp_int_t a_w = a->dim_info[1].length;
+    mp_int_t count = kh * kw;
+    mp_int_t rank = count / 2;
+    mp_float_t *window = uumpy_new(mp_float_t, count);
+
+    for (mp_int_t i=0; i < a_h; i++) {
+        for (mp_int_t j=0; j < a_w; j++) {
+            mp_float_t *w = window;
+
+            for (mp_int_t m=0; m < kh; m++) {
+                mp_int_t r = _signal_boundary_index(i - kh / 2 + m, a_h, boundary->mode);
+                for (mp_int_t n=0; n < kw; n++) {
+                    mp_int_t c = _signal_boundary_index(j - kw / 2 + n, a_w, boundary->mode);
+                    *w++ = (r < 0 || c < 0) ? boundary->fill_value :
+                        a_data[r * a->dim_info[0].stride + c * a->dim_info[1].stride];
+                }
+            }
+
+            // Quickselect the value of the required rank
+            mp_int_t lo = 0, hi = count - 1;
+            while (lo < hi) {
+                mp_float_t pivot = window[(lo + hi) / 2];
+                mp_int_t p = lo, q = hi;
+                while (p <= q) {
+                    while (window[p] < pivot) {
+                        p++;
+                    }
+                    while (window[q] > pivot) {
+                        q--;
+                    }
+                    if (p <= q) {
+                        mp_float_t tmp = window[p];
+                        window[p++] = window[q];
+                        window[q--] = tmp;
+                    }
+                }
+                if (rank <= q) {
+                    hi = q;
+                } else if (rank >= p) {
+                    lo = p;
+                } else {
+                    break;
+                }
+            }
+
+            dest_data[i * a_w + j] = window[rank];
+        }
+    }
+
+    m_del(mp_float_t, window, count);
+}
+
+// For 8-bit data we can use Huang's algorithm: keep a histogram of the
+// window, update it by one column as the window slides along each row and
+// walk the running median up or down from where it was.
+static void _signal_median_byte(uumpy_obj_ndarray_t *dest, uumpy_obj_ndarray_t *a,
+                                mp_int_t kh, mp_int_t kw, uumpy_signal_boundary *boundary) {
+    bool is_signed = (a->typecode == 'b');
+    int bias = is_signed ? 128 : 0;
+    byte *a_data = ((byte *) a->data) + a->base_offset;
+    byte *dest_data = (byte *) dest->data;
+    mp_int_t a_h = a->dim_info[0].length;
+    mp_int_t a_w = a->dim_info[1].length;
+    mp_int_t rs = a->dim_info[0].stride;
+    mp_int_t cs = a->dim_info[1].stride;
+    mp_int_t rank = (kh * kw) / 2;
+    int fill = (int) boundary->fill_value;
+    mp_int_t *hist = uumpy_new(mp_int_t, 256);
+    mp_int_t *rows = uumpy_new(mp_int_t, kh);
+
+    if (is_signed) {
+        fill = (byte) (signed char) fill;
+    }
+    fill = ((byte) fill + bias) & 0xff;
+
+    for (mp_int_t i=0; i < a_h; i++) {
+        memset(hist, 0, 256 * sizeof(mp_int_t));
+
+        for (mp_int_t m=0; m < kh; m++) {
+            rows[m] = _signal_boundary_index(i - kh / 2 + m, a_h, boundary->mode);
+        }
+
+        // Fill the histogram for the window one column to the left of the
+        // start of the row, which the loop below then slides into place
+        for (mp_int_t n = -1; n < kw - 1; n++) {
+            mp_int_t c = _signal_boundary_index(n - kw / 2, a_w, boundary->mode);
+            for (mp_int_t m=0; m < kh; m++) {
+                int v = (rows[m] < 0 || c < 0) ? fill : ((a_data[rows[m] * rs + c * cs] + bias) & 0xff);
+                hist[v]++;
+            }
+        }
+
+        int med = 0;
+        mp_int_t below = 0;
+
+        for (mp_int_t j=0; j < a_w; j++) {
+            mp_int_t c_out = _signal_boundary_index(j - 1 - kw / 2, a_w, boundary->mode);
+            mp_int_t c_in = _signal_boundary_index(j + kw - 1 - kw / 2, a_w, boundary->mode);
+
+            for (mp_int_t m=0; m < kh; m++) {
+                int v_out = (rows[m] < 0 || c_out < 0) ? fill : ((a_data[rows[m] * rs + c_out * cs] + bias) & 0xff);
+                int v_in = (rows[m] < 0 || c_in < 0) ? fill : ((a_data[rows[m] * rs + c_in * cs] + bias) & 0xff);
+                hist[v_out]--;
+                below -= (v_out < med);
+                hist[v_in]++;
+                below += (v_in < med);
+            }
+
+            while (below > rank) {
+                med--;
+                below -= hist[med];
+            }
+            while (below + hist[med] <= rank) {
+                below += hist[med];
+                med++;
+            }
+
+            dest_data[i * a_w + j] = (byte) (med - bias);
+        }
+    }
+
+    m_del(mp_int_t, rows, kh);
+    m_del(mp_int_t, hist, 256);
+}
+
+static mp_obj_t _signal_filter_helper(int filter, size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_input,
+        ARG_size,
+        ARG_mode,
+        ARG_cval,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_input, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_size,  MP_ARG_OBJ,                   {.u_obj = MP_OBJ_NEW_SMALL_INT(3)} },
+        { MP_QSTR_mode,  MP_ARG_OBJ,                   {.u_obj = MP_OBJ_NEW_QSTR(MP_QSTR_reflect)} },
+        { MP_QSTR_cval,  MP_ARG_OBJ,                   {.u_obj = MP_OBJ_NEW_SMALL_INT(0)} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_obj_ndarray_t *a;
+    mp_obj_t input = args[ARG_input].u_obj;
+    bool byte_median = false;
+
+    if (filter == UUMPY_SIGNAL_FILTER_MEDIAN &&
+        mp_obj_is_type(input, MP_OBJ_FROM_PTR(&uumpy_type_ndarray)) &&
+        (((uumpy_obj_ndarray_t *) MP_OBJ_TO_PTR(input))->typecode == 'B' ||
+         ((uumpy_obj_ndarray_t *) MP_OBJ_TO_PTR(input))->typecode == 'b')) {
+        a = MP_OBJ_TO_PTR(input);
+        byte_median = true;
+    } else {
+        a = _signal_float_array(input);
+    }
+
+    mp_int_t dim_count = a->dim_count;
+    if (dim_count != 1 && dim_count != 2) {
+        mp_raise_ValueError(MP_ERROR_TEXT("filters only support 1-D and 2-D arrays"));
+    }
+
+    // Treat 1-D input as a single row
+    mp_int_t sizes[2] = {1, 1};
+    mp_int_t count;
+    mp_obj_t *items;
+
+    if (uumpy_util_get_list_tuple(args[ARG_size].u_obj, &count, &items)) {
+        if (count != dim_count) {
+            mp_raise_ValueError(MP_ERROR_TEXT("size must have one entry per dimension"));
+        }
+        for (mp_int_t i=0; i < count; i++) {
+            sizes[i + 2 - count] = mp_obj_get_int(items[i]);
+        }
+    } else {
+        sizes[1] = mp_obj_get_int(args[ARG_size].u_obj);
+        if (dim_count == 2) {
+            sizes[0] = sizes[1];
+        }
+    }
+    if (sizes[0] < 1 || sizes[1] < 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("filter size must be at least 1"));
+    }
+
+    if (dim_count == 1) {
+        uumpy_dim_info row_dims[2] = {{1, 0}, a->dim_info[0]};
+        a = ndarray_new_view(a, a->base_offset, 2, row_dims);
+    }
+
+    uumpy_signal_boundary boundary = {
+        .mode = _signal_get_filter_mode(args[ARG_mode].u_obj),
+        .fill_value = mp_obj_get_float(args[ARG_cval].u_obj),
+    };
+
+    mp_int_t a_h = a->dim_info[0].length;
+    mp_int_t a_w = a->dim_info[1].length;
+    mp_int_t dims[2] = {a_h, a_w};
+    uumpy_obj_ndarray_t *dest = ndarray_new(byte_median ? a->typecode : UUMPY_DEFAULT_TYPE, 2, dims);
+
+    if (a_h == 0 || a_w == 0) {
+        // Nothing to do
+    } else if (byte_median) {
+        _signal_median_byte(dest, a, sizes[0], sizes[1], &boundary);
+    } else if (filter == UUMPY_SIGNAL_FILTER_MEDIAN) {
+        _signal_median_float(dest, a, sizes[0], sizes[1], &boundary);
+    } else {
+        mp_float_t *a_data = ((mp_float_t *) a->data) + a->base_offset;
+        mp_float_t *dest_data = (mp_float_t *) dest->data;
+        mp_int_t work_size = 2 * (MAX(a_h, a_w) + MAX(sizes[0], sizes[1]) - 1);
+        mp_float_t *work = uumpy_new(mp_float_t, work_size);
+        mp_float_t *temp = uumpy_new(mp_float_t, a_h * a_w);
+
+        // Filter along the rows into a temporary and then down the columns
+        for (mp_int_t pass=0; pass < 2; pass++) {
+            mp_int_t lines = pass ? a_w : a_h;
+            mp_int_t length = pass ? a_h : a_w;
+            mp_int_t size = sizes[1 - pass];
+
+            for (mp_int_t l=0; l < lines; l++) {
+                mp_float_t *d = pass ? dest_data + l : temp + l * a_w;
+                mp_int_t d_stride = pass ? a_w : 1;
+                const mp_float_t *s = pass ? temp + l : a_data + l * a->dim_info[0].stride;
+                mp_int_t s_stride = pass ? a_w : a->dim_info[1].stride;
+
+                if (filter == UUMPY_SIGNAL_FILTER_UNIFORM) {
+                    _signal_uniform_1d(d, d_stride, s, s_stride, length, size, &boundary, work);
+                } else {
+                    _signal_minmax_1d(d, d_stride, s, s_stride, length, size,
+                                      filter == UUMPY_SIGNAL_FILTER_MAX, &boundary, work);
+                }
+            }
+        }
+
+        m_del(mp_float_t, temp, a_h * a_w);
+        m_del(mp_float_t, work, work_size);
+    }
+
+    if (dim_count == 1) {
+        dest->dim_count = 1;
+        dest->dim_info[0] = dest->dim_info[1];
+    }
+
+    return MP_OBJ_FROM_PTR(dest);
+}
+
+#define UUMPY_SIGNAL_FILTER_FUN(name, filter) \
+    static mp_obj_t uumpy_signal_ ## name(size_t n_args, const mp_obj_t *args, mp_map_t *kwargs) { \
+        return _signal_filter_helper(filter, n_args, args, kwargs); \
+    } \
+    static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_ ## name ## _obj, 1, uumpy_signal_ ## name)
+
+UUMPY_SIGNAL_FILTER_FUN(maximum_filter, UUMPY_SIGNAL_FILTER_MAX);
+UUMPY_SIGNAL_FILTER_FUN(minimum_filter, UUMPY_SIGNAL_FILTER_MIN);
+UUMPY_SIGNAL_FILTER_FUN(uniform_filter, UUMPY_SIGNAL_FILTER_UNIFORM);
+UUMPY_SIGNAL_FILTER_FUN(median_filter, UUMPY_SIGNAL_FILTER_MEDIAN);
+
+// Peak and zero crossing detection. These return the indices they find as
+// an integer array. We allocate for the worst case, fill it in one pass and
+// then trim the data block down to what was used.
+
+static uumpy_obj_ndarray_t *_signal_index_array(mp_int_t max_count) {
+    return ndarray_new('i', 1, &max_count);
+}
+
+static void _signal_index_array_trim(uumpy_obj_ndarray_t *indices, mp_int_t max_count, mp_int_t count) {
+    #if UUMPY_DATA_OVERALIGNED
+    // Over-aligned data doesn't start at the beginning of its block, so it
+    // can't be resized and the spare space is just left at the end
+    (void) max_count;
+    #else
+    indices->data = uumpy_renew(int, indices->data, max_count, MAX(count, 1));
+    #endif
+    indices->dim_info[0].length = count;
+}
+
+static uumpy_obj_ndarray_t *_signal_1d_float_array(mp_obj_t x_in) {
+    uumpy_obj_ndarray_t *x = _signal_float_array(x_in);
+
+    if (x->dim_count != 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("input must be 1-D"));
+    }
+
+    return x;
+}
+
+// Height and prominence limits can be given as a minimum or as a
+// (min, max) tuple where either may be None. Returns false if no limit.
+static bool _signal_get_limits(mp_obj_t limits_in, mp_float_t *lo, mp_float_t *hi) {
+    mp_int_t count;
+    mp_obj_t *items;
+
+    *lo = -INFINITY;
+    *hi = INFINITY;
+
+    if (limits_in == mp_const_none) {
+        return false;
+    } else if (uumpy_util_get_list_tuple(limits_in, &count, &items)) {
+        if (count != 2) {
+            mp_raise_ValueError(MP_ERROR_TEXT("limits must be a value or (min, max)"));
+        }
+        if (items[0] != mp_const_none) {
+            *lo = mp_obj_get_float(items[0]);
+        }
+        if (items[1] != mp_const_none) {
+            *hi = mp_obj_get_float(items[1]);
+        }
+    } else {
+        *lo = mp_obj_get_float(limits_in);
+    }
+
+    return true;
+}
+
+// Sort the peak numbers in order by the height of their peaks. A heap sort
+// keeps this O(n log n) without needing any recursion.
+static void _signal_sift_peak(mp_int_t *order, mp_int_t root, mp_int_t end, const int *peaks,
+                              const mp_float_t *x, mp_int_t stride) {
+    while (2 * root + 1 < end) {
+        mp_int_t child = 2 * root + 1;
+        if (child + 1 < end && x[peaks[order[child + 1]] * stride] > x[peaks[order[child]] * stride]) {
+            child++;
+        }
+        if (x[peaks[order[child]] * stride] <= x[peaks[order[root]] * stride]) {
+            break;
+        }
+        mp_int_t tmp = order[root];
+        order[root] = order[child];
+        order[child] = tmp;
+        root = child;
+    }
+}
+
+static void _signal_sort_peaks(mp_int_t *order, mp_int_t count, const int *peaks,
+                               const mp_float_t *x, mp_int_t stride) {
+    for (mp_int_t i=0; i < count; i++) {
+        order[i] = i;
+    }
+
+    for (mp_int_t i = count / 2 - 1; i >= 0; i--) {
+        _signal_sift_peak(order, i, count, peaks, x, stride);
+    }
+
+    for (mp_int_t end = count - 1; end > 0; end--) {
+        mp_int_t tmp = order[0];
+        order[0] = order[end];
+        order[end] = tmp;
+        _signal_sift_peak(order, 0, end, peaks, x, stride);
+    }
+}
+
+// The prominence of a peak is its height above the higher of the lowest
+// points between it and the nearest higher sample on either side
+static mp_float_t _signal_peak_prominence(const mp_float_t *x, mp_int_t stride, mp_int_t length,
+                                          mp_int_t peak) {
+    mp_float_t height = x[peak * stride];
+    mp_float_t left_min = height;
+    mp_float_t right_min = height;
+
+    for (mp_int_t i = peak; i >= 0 && x[i * stride] <= height; i--) {
+        if (x[i * stride] < left_min) {
+            left_min = x[i * stride];
+        }
+    }
+    for (mp_int_t i = peak; i < length && x[i * stride] <= height; i++) {
+        if (x[i * stride] < right_min) {
+            right_min = x[i * stride];
+        }
+    }
+
+    return height - MAX(left_min, right_min);
+}
+
+static mp_obj_t uumpy_signal_find_peaks(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_x,
+        ARG_height,
+        ARG_distance,
+        ARG_prominence,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_x,          MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_height,     MP_ARG_OBJ,                   {.u_obj = mp_const_none} },
+        { MP_QSTR_distance,   MP_ARG_OBJ,                   {.u_obj = mp_const_none} },
+        { MP_QSTR_prominence, MP_ARG_OBJ,                   {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_obj_ndarray_t *x_array = _signal_1d_float_array(args[ARG_x].u_obj);
+    mp_float_t *x = ((mp_float_t *) x_array->data) + x_array->base_offset;
+    mp_int_t stride = x_array->dim_info[0].stride;
+    mp_int_t length = x_array->dim_info[0].length;
+
+    // Peaks are at least two samples apart, and never at the ends
+    mp_int_t max_count = (length > 2) ? (length - 1) / 2 : 0;
+    uumpy_obj_ndarray_t *peak_array = _signal_index_array(max_count);
+    int *peaks = (int *) peak_array->data;
+    mp_int_t count = 0;
+
+    mp_float_t lo, hi;
+    bool check_height = _signal_get_limits(args[ARG_height].u_obj, &lo, &hi);
+
+    // A plateau counts as a single peak at its middle (rounding down)
+    mp_int_t i = 1;
+    while (i < length - 1) {
+        mp_float_t v = x[i * stride];
+        if (x[(i - 1) * stride] < v) {
+            mp_int_t ahead = i + 1;
+            while (ahead < length - 1 && x[ahead * stride] == v) {
+                ahead++;
+            }
+            if (x[ahead * stride] < v && (!check_height || (v >= lo && v <= hi))) {
+                peaks[count++] = (i + ahead - 1) / 2;
+            }
+            i = ahead;
+        } else {
+            i++;
+        }
+    }
+
+    if (args[ARG_distance].u_obj != mp_const_none && count > 1) {
+        mp_float_t distance = mp_obj_get_float(args[ARG_distance].u_obj);
+        if (distance < 1) {
+            mp_raise_ValueError(MP_ERROR_TEXT("distance must be at least 1"));
+        }
+        mp_int_t min_gap = (mp_int_t) MICROPY_FLOAT_C_FUN(ceil)(distance);
+
+        // Working from the highest peak down, each peak that survives
+        // knocks out its lower neighbours that are too close. Since the
+        // peaks are in index order this only looks at the ones it removes.
+        mp_int_t *order = uumpy_new(mp_int_t, count);
+        byte *keep = uumpy_new(byte, count);
+        memset(keep, 1, count);
+        _signal_sort_peaks(order, count, peaks, x, stride);
+
+        for (mp_int_t n = count - 1; n >= 0; n--) {
+            mp_int_t p = order[n];
+            if (!keep[p]) {
+                continue;
+            }
+            for (mp_int_t k = p - 1; k >= 0 && peaks[p] - peaks[k] < min_gap; k--) {
+                keep[k] = 0;
+            }
+            for (mp_int_t k = p + 1; k < count && peaks[k] - peaks[p] < min_gap; k++) {
+                keep[k] = 0;
+            }
+        }
+
+        mp_int_t kept = 0;
+        for (mp_int_t n=0; n < count; n++) {
+            if (keep[n]) {
+                peaks[kept++] = peaks[n];
+            }
+        }
+        m_del(byte, keep, count);
+        m_del(mp_int_t, order, count);
+
+        count = kept;
+    }
+
+    if (_signal_get_limits(args[ARG_prominence].u_obj, &lo, &hi)) {
+        mp_int_t kept = 0;
+        for (mp_int_t n=0; n < count; n++) {
+            mp_float_t prominence = _signal_peak_prominence(x, stride, length, peaks[n]);
+            if (prominence >= lo && prominence <= hi) {
+                peaks[kept++] = peaks[n];
+            }
+        }
+        count = kept;
+    }
+
+    _signal_index_array_trim(peak_array, max_count, count);
+
+    return MP_OBJ_FROM_PTR(peak_array);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_find_peaks_obj, 1, uumpy_signal_find_peaks);
+
+// Returns the indices of the samples whose sign differs from the previous
+// sample. Zero is treated as positive.
+static mp_obj_t uumpy_signal_zero_crossings(mp_obj_t x_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_obj_ndarray_t *x_array = _signal_1d_float_array(x_in);
+    mp_float_t *x = ((mp_float_t *) x_array->data) + x_array->base_offset;
+    mp_int_t stride = x_array->dim_info[0].stride;
+    mp_int_t length = x_array->dim_info[0].length;
+
+    mp_int_t max_count = (length > 1) ? length - 1 : 0;
+    uumpy_obj_ndarray_t *crossing_array = _signal_index_array(max_count);
+    int *crossings = (int *) crossing_array->data;
+    mp_int_t count = 0;
+
+    if (length > 0) {
+        bool negative = x[0] < 0;
+        for (mp_int_t i=1; i < length; i++) {
+            bool next_negative = x[i * stride] < 0;
+            if (next_negative != negative) {
+                crossings[count++] = i;
+            }
+            negative = next_negative;
+        }
+    }
+
+    _signal_index_array_trim(crossing_array, max_count, count);
+
+    return MP_OBJ_FROM_PTR(crossing_array);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_signal_zero_crossings_obj, uumpy_signal_zero_crossings);
+
+// Tracking a handful of frequencies is much cheaper than a full FFT. Both
+// of these objects keep their state between calls to process() so a
+// stream can be fed in blocks of any size, and both report the power in
+// each bin, optionally writing it into a preallocated array.
+
+static uumpy_obj_ndarray_t *_signal_get_bin_output(mp_obj_t out_in, mp_int_t bin_count) {
+    if (out_in == mp_const_none) {
+        return ndarray_new(UUMPY_DEFAULT_TYPE, 1, &bin_count);
+    }
+
+    uumpy_obj_ndarray_t *dest = MP_OBJ_TO_PTR(out_in);
+    if (!mp_obj_is_type(out_in, MP_OBJ_FROM_PTR(&uumpy_type_ndarray)) ||
+        dest->typecode != UUMPY_DEFAULT_TYPE || dest->dim_count != 1) {
+        mp_raise_TypeError(MP_ERROR_TEXT("out must be a 1-D float array"));
+    }
+    if (dest->dim_info[0].length != bin_count) {
+        mp_raise_ValueError(MP_ERROR_TEXT("out must have one entry per frequency"));
+    }
+
+    return dest;
+}
+
+// Get the angular frequencies, in radians per sample, of the bins
+static mp_float_t *_signal_get_bin_omegas(mp_obj_t freqs_in, mp_obj_t fs_in, mp_int_t *bin_count) {
+    uumpy_obj_ndarray_t *freqs = _signal_float_array(freqs_in);
+
+    if (freqs->dim_count != 1 || freqs->dim_info[0].length == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("freqs must be a non-empty 1-D array"));
+    }
+
+    mp_float_t scale = 2 * UUMPY_PI / mp_obj_get_float(fs_in);
+    mp_float_t *freq_data = ((mp_float_t *) freqs->data) + freqs->base_offset;
+    mp_int_t count = freqs->dim_info[0].length;
+    mp_float_t *omegas = uumpy_new(mp_float_t, count);
+
+    for (mp_int_t k=0; k < count; k++) {
+        omegas[k] = freq_data[k * freqs->dim_info[0].stride] * scale;
+    }
+
+    *bin_count = count;
+    return omegas;
+}
+
+// The Goertzel algorithm runs a second order resonator for each frequency.
+// Since only the magnitude is wanted the bins need not be integer
+// multiples of fs/N, and the power covers every sample since the last
+// reset().
+typedef struct _uumpy_signal_obj_goertzel_t {
+    mp_obj_base_t base;
+    mp_int_t bin_count;
+    mp_float_t *coeffs;
+    mp_float_t *s1;
+    mp_float_t *s2;
+} uumpy_signal_obj_goertzel_t;
+
+static mp_obj_t uumpy_signal_goertzel_make_new(const mp_obj_type_t *type_in, size_t n_args,
+                                               size_t n_kw, const mp_obj_t *all_args) {
+    enum {
+        ARG_freqs,
+        ARG_fs,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_freqs, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_fs,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, all_args + n_args);
+    mp_arg_parse_all(n_args, all_args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_signal_obj_goertzel_t *o = uumpy_new_obj(uumpy_signal_obj_goertzel_t);
+    o->base.type = type_in;
+
+    // The omegas are turned into coefficients in place
+    o->coeffs = _signal_get_bin_omegas(args[ARG_freqs].u_obj, args[ARG_fs].u_obj, &o->bin_count);
+    for (mp_int_t k=0; k < o->bin_count; k++) {
+        o->coeffs[k] = 2 * COS(o->coeffs[k]);
+    }
+
+    o->s1 = uumpy_new(mp_float_t, 2 * o->bin_count);
+    o->s2 = o->s1 + o->bin_count;
+    memset(o->s1, 0, 2 * o->bin_count * sizeof(mp_float_t));
+
+    return MP_OBJ_FROM_PTR(o);
+}
+
+static mp_obj_t uumpy_signal_goertzel_process(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_self,
+        ARG_x,
+        ARG_out,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_self, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_x,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_out,  MP_ARG_OBJ,                   {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_signal_obj_goertzel_t *self = MP_OBJ_TO_PTR(args[ARG_self].u_obj);
+    uumpy_obj_ndarray_t *x = _signal_1d_float_array(args[ARG_x].u_obj);
+    uumpy_obj_ndarray_t *dest = _signal_get_bin_output(args[ARG_out].u_obj, self->bin_count);
+
+    mp_float_t *x_data = ((mp_float_t *) x->data) + x->base_offset;
+    mp_int_t x_stride = x->dim_info[0].stride;
+    mp_int_t n_in = x->dim_info[0].length;
+    mp_float_t *dest_data = ((mp_float_t *) dest->data) + dest->base_offset;
+
+    // Run each resonator over the whole block so its state stays in registers
+    for (mp_int_t k=0; k < self->bin_count; k++) {
+        mp_float_t coeff = self->coeffs[k];
+        mp_float_t s1 = self->s1[k];
+        mp_float_t s2 = self->s2[k];
+
+        for (mp_int_t i=0; i < n_in; i++) {
+            mp_float_t s0 = x_data[i * x_stride] + coeff * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+
+        self->s1[k] = s1;
+        self->s2[k] = s2;
+        dest_data[k * dest->dim_info[0].stride] = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+    }
+
+    return MP_OBJ_FROM_PTR(dest);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_goertzel_process_obj, 2, uumpy_signal_goertzel_process);
+
+static mp_obj_t uumpy_signal_goertzel_reset(mp_obj_t self_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_signal_obj_goertzel_t *self = MP_OBJ_TO_PTR(self_in);
+
+    memset(self->s1, 0, 2 * self->bin_count * sizeof(mp_float_t));
+
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_signal_goertzel_reset_obj, uumpy_signal_goertzel_reset);
+
+static const mp_rom_map_elem_t uumpy_signal_goertzel_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_process), MP_ROM_PTR(&uumpy_signal_goertzel_process_obj) },
+    { MP_ROM_QSTR(MP_QSTR_reset), MP_ROM_PTR(&uumpy_signal_goertzel_reset_obj) },
+};
+static MP_DEFINE_CONST_DICT(uumpy_signal_goertzel_locals_dict, uumpy_signal_goertzel_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    uumpy_signal_type_Goertzel,
+    MP_QSTR_Goertzel,
+    MP_TYPE_FLAG_NONE,
+    make_new, uumpy_signal_goertzel_make_new,
+    locals_dict, &uumpy_signal_goertzel_locals_dict
+);
+
+// A sliding DFT gives the spectrum over the last n samples, updated for
+// every sample at a cost of one complex multiply per bin:
+//     S(t) = x(t) - z^n x(t-n) + z S(t-1),  where z = exp(-j omega)
+// For frequencies that are a whole number of bins z^n is 1, but keeping
+// the term means any frequency can be tracked exactly.
+typedef struct _uumpy_signal_obj_sliding_dft_t {
+    mp_obj_base_t base;
+    mp_int_t bin_count;
+    mp_int_t window_length;
+    mp_int_t head;
+    // z and z^n for each bin, followed by the real and imaginary state
+    mp_float_t *z_re;
+    mp_float_t *z_im;
+    mp_float_t *zn_re;
+    mp_float_t *zn_im;
+    mp_float_t *s_re;
+    mp_float_t *s_im;
+    // The last n samples, with the oldest at head
+    mp_float_t *ring;
+} uumpy_signal_obj_sliding_dft_t;
+
+static mp_obj_t uumpy_signal_sliding_dft_make_new(const mp_obj_type_t *type_in, size_t n_args,
+                                                  size_t n_kw, const mp_obj_t *all_args) {
+    enum {
+        ARG_freqs,
+        ARG_fs,
+        ARG_n,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_freqs, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_fs,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_n,     MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, all_args + n_args);
+    mp_arg_parse_all(n_args, all_args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_int_t n = args[ARG_n].u_int;
+    if (n < 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("window length must be at least 1"));
+    }
+
+    uumpy_signal_obj_sliding_dft_t *o = uumpy_new_obj(uumpy_signal_obj_sliding_dft_t);
+    o->base.type = type_in;
+    o->window_length = n;
+    o->head = 0;
+
+    mp_int_t bin_count;
+    mp_float_t *omegas = _signal_get_bin_omegas(args[ARG_freqs].u_obj, args[ARG_fs].u_obj, &bin_count);
+    o->bin_count = bin_count;
+
+    o->z_re = uumpy_new(mp_float_t, 6 * bin_count);
+    o->z_im = o->z_re + bin_count;
+    o->zn_re = o->z_im + bin_count;
+    o->zn_im = o->zn_re + bin_count;
+    o->s_re = o->zn_im + bin_count;
+    o->s_im = o->s_re + bin_count;
+
+    for (mp_int_t k=0; k < bin_count; k++) {
+        o->z_re[k] = COS(omegas[k]);
+        o->z_im[k] = -SIN(omegas[k]);
+        o->zn_re[k] = COS(omegas[k] * n);
+        o->zn_im[k] = -SIN(omegas[k] * n);
+    }
+    memset(o->s_re, 0, 2 * bin_count * sizeof(mp_float_t));
+    m_del(mp_float_t, omegas, bin_count);
+
+    o->ring = uumpy_new(mp_float_t, n);
+    memset(o->ring, 0, n * sizeof(mp_float_t));
+
+    return MP_OBJ_FROM_PTR(o);
+}
+
+static mp_obj_t uumpy_signal_sliding_dft_process(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_self,
+        ARG_x,
+        ARG_out,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_self, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_x,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_out,  MP_ARG_OBJ,                   {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_signal_obj_sliding_dft_t *self = MP_OBJ_TO_PTR(args[ARG_self].u_obj);
+    uumpy_obj_ndarray_t *x = _signal_1d_float_array(args[ARG_x].u_obj);
+    uumpy_obj_ndarray_t *dest = _signal_get_bin_output(args[ARG_out].u_obj, self->bin_count);
+
+    mp_float_t *x_data = ((mp_float_t *) x->data) + x->base_offset;
+    mp_int_t x_stride = x->dim_info[0].stride;
+    mp_int_t n_in = x->dim_info[0].length;
+    mp_int_t n = self->window_length;
+    mp_float_t *dest_data = ((mp_float_t *) dest->data) + dest->base_offset;
+
+    for (mp_int_t k=0; k < self->bin_count; k++) {
+        mp_float_t z_re = self->z_re[k], z_im = self->z_im[k];
+        mp_float_t zn_re = self->zn_re[k], zn_im = self->zn_im[k];
+        mp_float_t s_re = self->s_re[k], s_im = self->s_im[k];
+        mp_int_t ring_index = self->head;
+
+        for (mp_int_t i=0; i < n_in; i++) {
+            // The sample leaving the window is either in this block or
+            // in the ring of samples from earlier blocks
+            mp_float_t old;
+            if (i >= n) {
+                old = x_data[(i - n) * x_stride];
+            } else {
+                old = self->ring[ring_index];
+                if (++ring_index == n) {
+                    ring_index = 0;
+                }
+            }
+
+            mp_float_t t_re = x_data[i * x_stride] - zn_re * old;
+            mp_float_t t_im = -zn_im * old;
+            mp_float_t next_re = t_re + z_re * s_re - z_im * s_im;
+            s_im = t_im + z_re * s_im + z_im * s_re;
+            s_re = next_re;
+        }
+
+        self->s_re[k] = s_re;
+        self->s_im[k] = s_im;
+        dest_data[k * dest->dim_info[0].stride] = s_re * s_re + s_im * s_im;
+    }
+
+    // Keep the most recent n samples
+    for (mp_int_t i = MAX(0, n_in - n); i < n_in; i++) {
+        self->ring[self->head] = x_data[i * x_stride];
+        if (++self->head == n) {
+            self->head = 0;
+        }
+    }
+
+    return MP_OBJ_FROM_PTR(dest);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_sliding_dft_process_obj, 2, uumpy_signal_sliding_dft_process);
+
+static mp_obj_t uumpy_signal_sliding_dft_reset(mp_obj_t self_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_signal_obj_sliding_dft_t *self = MP_OBJ_TO_PTR(self_in);
+
+    self->head = 0;
+    memset(self->s_re, 0, 2 * self->bin_count * sizeof(mp_float_t));
+    memset(self->ring, 0, self->window_length * sizeof(mp_float_t));
+
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_signal_sliding_dft_reset_obj, uumpy_signal_sliding_dft_reset);
+
+static const mp_rom_map_elem_t uumpy_signal_sliding_dft_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_process), MP_ROM_PTR(&uumpy_signal_sliding_dft_process_obj) },
+    { MP_ROM_QSTR(MP_QSTR_reset), MP_ROM_PTR(&uumpy_signal_sliding_dft_reset_obj) },
+};
+static MP_DEFINE_CONST_DICT(uumpy_signal_sliding_dft_locals_dict, uumpy_signal_sliding_dft_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    uumpy_signal_type_SlidingDFT,
+    MP_QSTR_SlidingDFT,
+    MP_TYPE_FLAG_NONE,
+    make_new, uumpy_signal_sliding_dft_make_new,
+    locals_dict, &uumpy_signal_sliding_dft_locals_dict
+);
+
+// Per-channel block statistics in a single pass. The line kernel writes
+// RMS, peak, crest factor and (excess) kurtosis as four consecutive values
+// and block_stats() hands them back as views into that one array. The
+// central moments are updated incrementally, which is much better behaved
+// than working from the raw power sums.
+#define UUMPY_SIGNAL_STAT_RMS (0)
+#define UUMPY_SIGNAL_STAT_PEAK (1)
+#define UUMPY_SIGNAL_STAT_CREST (2)
+#define UUMPY_SIGNAL_STAT_KURTOSIS (3)
+#define UUMPY_SIGNAL_STAT_COUNT (4)
+
+static bool _signal_block_stats_line(size_t depth,
+                                     uumpy_obj_ndarray_t *dest, mp_int_t dest_offset,
+                                     uumpy_obj_ndarray_t *src, mp_int_t src_offset,
+                                     struct _uumpy_universal_spec *spec) {
+    mp_float_t *src_data = ((mp_float_t *) src->data) + src_offset;
+    mp_float_t *dest_data = ((mp_float_t *) dest->data) + dest_offset;
+    mp_int_t src_stride = src->dim_info[depth].stride;
+    mp_int_t src_length = src->dim_info[depth].length;
+    mp_int_t dest_stride = dest->dim_info[depth].stride;
+
+    mp_float_t mean = 0, m2 = 0, m3 = 0, m4 = 0;
+    mp_float_t peak = 0;
+
+    for (mp_int_t i=0; i < src_length; i++) {
+        mp_float_t v = src_data[i * src_stride];
+        mp_float_t n = i + 1;
+        mp_float_t delta = v - mean;
+        mp_float_t delta_n = delta / n;
+        mp_float_t delta_n2 = delta_n * delta_n;
+        mp_float_t term = delta * delta_n * i;
+
+        mean += delta_n;
+        m4 += term * delta_n2 * (n * n - 3 * n + 3) + 6 * delta_n2 * m2 - 4 * delta_n * m3;
+        m3 += term * delta_n * (n - 2) - 3 * delta_n * m2;
+        m2 += term;
+
+        mp_float_t mag = (v < 0) ? -v : v;
+        if (mag > peak) {
+            peak = mag;
+        }
+    }
+
+    mp_float_t rms = MICROPY_FLOAT_C_FUN(sqrt)(m2 / src_length + mean * mean);
+
+    dest_data[UUMPY_SIGNAL_STAT_RMS * dest_stride] = rms;
+    dest_data[UUMPY_SIGNAL_STAT_PEAK * dest_stride] = peak;
+    dest_data[UUMPY_SIGNAL_STAT_CREST * dest_stride] = peak / rms;
+    dest_data[UUMPY_SIGNAL_STAT_KURTOSIS * dest_stride] = src_length * m4 / (m2 * m2) - 3;
+
+    return true;
+}
+
+// Returns a tuple (rms, peak, crest, kurtosis) with the given axis reduced
+static mp_obj_t uumpy_signal_block_stats(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_x,
+        ARG_axis,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_x,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_axis, MP_ARG_OBJ,                   {.u_obj = MP_OBJ_NEW_SMALL_INT(-1)} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_obj_ndarray_t *x = _signal_float_array(args[ARG_x].u_obj);
+    mp_int_t axis = _signal_get_axis(x, args[ARG_axis].u_obj);
+    mp_int_t last = x->dim_count - 1;
+
+    if (x->dim_info[axis].length == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("cannot compute statistics of an empty axis"));
+    }
+
+    x = _signal_move_axis(x, axis, last);
+    uumpy_obj_ndarray_t *stats = _signal_apply_lines(x, last, UUMPY_SIGNAL_STAT_COUNT,
+                                                     _signal_block_stats_line, NULL);
+
+    mp_obj_t items[UUMPY_SIGNAL_STAT_COUNT];
+
+    for (mp_int_t k=0; k < UUMPY_SIGNAL_STAT_COUNT; k++) {
+        mp_int_t offset = stats->base_offset + k * stats->dim_info[last].stride;
+        if (last == 0) {
+            items[k] = UUMPY_BOXED_RESULT(mp_obj_new_float(((mp_float_t *) stats->data)[offset]));
+        } else {
+            items[k] = MP_OBJ_FROM_PTR(ndarray_new_view(stats, offset, last, stats->dim_info));
+        }
+    }
+
+    return mp_obj_new_tuple(UUMPY_SIGNAL_STAT_COUNT, items);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_block_stats_obj, 1, uumpy_signal_block_stats);
+
+// A peak envelope follower with separate attack and release time
+// constants, in seconds at the given sample rate (or in samples if fs is
+// not given). Input is either 1-D or (channels, samples) and the envelope
+// of each channel carries over from one call of process() to the next.
+typedef struct _uumpy_signal_obj_envelope_t {
+    mp_obj_base_t base;
+    mp_float_t attack;
+    mp_float_t release;
+    mp_int_t channels;
+    mp_float_t *state;
+} uumpy_signal_obj_envelope_t;
+
+static mp_float_t _signal_envelope_coeff(mp_float_t time_constant, mp_float_t fs) {
+    if (time_constant < 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("time constants must not be negative"));
+    }
+    return (time_constant == 0) ? 0 : MICROPY_FLOAT_C_FUN(exp)(-1 / (time_constant * fs));
+}
+
+static mp_obj_t uumpy_signal_envelope_make_new(const mp_obj_type_t *type_in, size_t n_args,
+                                               size_t n_kw, const mp_obj_t *all_args) {
+    enum {
+        ARG_attack,
+        ARG_release,
+        ARG_fs,
+        ARG_channels,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_attack,   MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_release,  MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_fs,       MP_ARG_OBJ,                   {.u_obj = MP_OBJ_NEW_SMALL_INT(1)} },
+        { MP_QSTR_channels, MP_ARG_KW_ONLY | MP_ARG_INT,  {.u_int = 1} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, all_args + n_args);
+    mp_arg_parse_all(n_args, all_args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_float_t fs = mp_obj_get_float(args[ARG_fs].u_obj);
+    mp_int_t channels = args[ARG_channels].u_int;
+
+    if (channels < 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("channels must be at least 1"));
+    }
+
+    uumpy_signal_obj_envelope_t *o = uumpy_new_obj(uumpy_signal_obj_envelope_t);
+    o->base.type = type_in;
+    o->attack = _signal_envelope_coeff(mp_obj_get_float(args[ARG_attack].u_obj), fs);
+    o->release = _signal_envelope_coeff(mp_obj_get_float(args[ARG_release].u_obj), fs);
+    o->channels = channels;
+    o->state = uumpy_new(mp_float_t, channels);
+    memset(o->state, 0, channels * sizeof(mp_float_t));
+
+    return MP_OBJ_FROM_PTR(o);
+}
+
+static mp_obj_t uumpy_signal_envelope_process(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_self,
+        ARG_x,
+        ARG_out,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_self, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_x,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_out,  MP_ARG_OBJ,                   {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_signal_obj_envelope_t *self = MP_OBJ_TO_PTR(args[ARG_self].u_obj);
+    uumpy_obj_ndarray_t *x = _signal_float_array(args[ARG_x].u_obj);
+
+    if (!((x->dim_count == 1 && self->channels == 1) ||
+          (x->dim_count == 2 && x->dim_info[0].length == self->channels))) {
+        mp_raise_ValueError(MP_ERROR_TEXT("input does not match the number of channels"));
+    }
+
+    uumpy_obj_ndarray_t *dest;
+
+    if (args[ARG_out].u_obj == mp_const_none) {
+        dest = ndarray_new_shaped_like(UUMPY_DEFAULT_TYPE, x, 0);
+    } else {
+        dest = MP_OBJ_TO_PTR(args[ARG_out].u_obj);
+        if (!mp_obj_is_type(args[ARG_out].u_obj, MP_OBJ_FROM_PTR(&uumpy_type_ndarray)) ||
+            dest->typecode != UUMPY_DEFAULT_TYPE) {
+            mp_raise_TypeError(MP_ERROR_TEXT("out must be a float array"));
+        }
+        if (!ndarray_compare_dimensions(dest, x)) {
+            mp_raise_ValueError(MP_ERROR_TEXT("out must be the same shape as the input"));
+        }
+    }
+
+    mp_int_t last = x->dim_count - 1;
+    mp_int_t length = x->dim_info[last].length;
+    mp_int_t x_stride = x->dim_info[last].stride;
+    mp_int_t dest_stride = dest->dim_info[last].stride;
+    mp_float_t attack = self->attack;
+    mp_float_t release = self->release;
+
+    for (mp_int_t c=0; c < self->channels; c++) {
+        mp_float_t *x_data = ((mp_float_t *) x->data) + x->base_offset;
+        mp_float_t *dest_data = ((mp_float_t *) dest->data) + dest->base_offset;
+        mp_float_t env = self->state[c];
+
+        if (last) {
+            x_data += c * x->dim_info[0].stride;
+            dest_data += c * dest->dim_info[0].stride;
+        }
+
+        for (mp_int_t i=0; i < length; i++) {
+            mp_float_t v = x_data[i * x_stride];
+            if (v < 0) {
+                v = -v;
+            }
+            mp_float_t coeff = (v > env) ? attack : release;
+            env = v + coeff * (env - v);
+            dest_data[i * dest_stride] = env;
+        }
+
+        self->state[c] = env;
+    }
+
+    return MP_OBJ_FROM_PTR(dest);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_signal_envelope_process_obj, 2, uumpy_signal_envelope_process);
+
+static mp_obj_t uumpy_signal_envelope_reset(mp_obj_t self_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_signal_obj_envelope_t *self = MP_OBJ_TO_PTR(self_in);
+
+    memset(self->state, 0, self->channels * sizeof(mp_float_t));
+
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_signal_envelope_reset_obj, uumpy_signal_envelope_reset);
+
+static const mp_rom_map_elem_t uumpy_signal_envelope_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_process), MP_ROM_PTR(&uumpy_signal_envelope_process_obj) },
+    { MP_ROM_QSTR(MP_QSTR_reset), MP_ROM_PTR(&uumpy_signal_envelope_reset_obj) },
+};
+static MP_DEFINE_CONST_DICT(uumpy_signal_envelope_locals_dict, uumpy_signal_envelope_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    uumpy_signal_type_EnvelopeFollower,
+    MP_QSTR_EnvelopeFollower,
+    MP_TYPE_FLAG_NONE,
+    make_new, uumpy_signal_envelope_make_new,
+    locals_dict, &uumpy_signal_envelope_locals_dict
+);
+
+static const mp_rom_map_elem_t uumpy_signal_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_resample_poly), MP_ROM_PTR(&uumpy_signal_resample_poly_obj) },
+    { MP_ROM_QSTR(MP_QSTR_decimate), MP_ROM_PTR(&uumpy_signal_decimate_obj) },
+    { MP_ROM_QSTR(MP_QSTR_Resampler), MP_ROM_PTR(&uumpy_signal_type_Resampler) },
+    { MP_ROM_QSTR(MP_QSTR_convolve2d), MP_ROM_PTR(&uumpy_signal_convolve2d_obj) },
+    { MP_ROM_QSTR(MP_QSTR_correlate2d), MP_ROM_PTR(&uumpy_signal_correlate2d_obj) },
+    { MP_ROM_QSTR(MP_QSTR_maximum_filter), MP_ROM_PTR(&uumpy_signal_maximum_filter_obj) },
+    { MP_ROM_QSTR(MP_QSTR_minimum_filter), MP_ROM_PTR(&uumpy_signal_minimum_filter_obj) },
+    { MP_ROM_QSTR(MP_QSTR_uniform_filter), MP_ROM_PTR(&uumpy_signal_uniform_filter_obj) },
+    { MP_ROM_QSTR(MP_QSTR_median_filter), MP_ROM_PTR(&uumpy_signal_median_filter_obj) },
+    { MP_ROM_QSTR(MP_QSTR_find_peaks), MP_ROM_PTR(&uumpy_signal_find_peaks_obj) },
+    { MP_ROM_QSTR(MP_QSTR_zero_crossings), MP_ROM_PTR(&uumpy_signal_zero_crossings_obj) },
+    { MP_ROM_QSTR(MP_QSTR_Goertzel), MP_ROM_PTR(&uumpy_signal_type_Goertzel) },
+    { MP_ROM_QSTR(MP_QSTR_SlidingDFT), MP_ROM_PTR(&uumpy_signal_type_SlidingDFT) },
+    { MP_ROM_QSTR(MP_QSTR_block_stats), MP_ROM_PTR(&uumpy_signal_block_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_EnvelopeFollower), MP_ROM_PTR(&uumpy_signal_type_EnvelopeFollower) },
+};
+static MP_DEFINE_CONST_DICT(uumpy_signal_module_globals, uumpy_signal_module_globals_table);
+
+// Define module object.
+const mp_obj_module_t uumpy_signal_module = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&uumpy_signal_module_globals,
+};
+
+#endif // UUMPY_ENABLE_SIGNAL
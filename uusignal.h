@@ -0,0 +1,42 @@
+/*
+ * This file is part of the uumpy project
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Nicko van Someren
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// SPDX-License-Identifier: MIT
+
+#ifndef UUMPY_INCLUDED_UUSIGNAL_H
+#define UUMPY_INCLUDED_UUSIGNAL_H
+
+#if UUMPY_ENABLE_SIGNAL
+
+extern const mp_obj_type_t uumpy_signal_type_Resampler;
+extern const mp_obj_type_t uumpy_signal_type_Goertzel;
+extern const mp_obj_type_t uumpy_signal_type_SlidingDFT;
+extern const mp_obj_type_t uumpy_signal_type_EnvelopeFollower;
+extern const mp_obj_module_t uumpy_signal_module;
+
+#endif // UUMPY_ENABLE_SIGNAL
+
+#endif // UUMPY_INCLUDED_UUSIGNAL_H
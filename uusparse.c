@@ -0,0 +1,570 @@
+/*
+ * This file is part of the uumpy project
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Nicko van Someren
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// SPDX-License-Identifier: MIT
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/binary.h"
+
+#include "moduumpy.h"
+#include "ufunc.h"
+#include "graph.h"
+#include "linalg.h"
+#include "uusparse.h"
+
+#if UUMPY_ENABLE_SPARSE
+
+// Sparse matrices hold their values in the default float type and their
+// indices as native integers. They are not ndarrays, but the products and
+// solvers all take and return ordinary ndarrays so that the two can be
+// mixed freely.
+
+// Get the input as an array of the default float type. If it already is
+// one then we use it as-is, so strided views don't get copied.
+static uumpy_obj_ndarray_t *_sparse_float_array(mp_obj_t x_in) {
+    if (mp_obj_is_type(x_in, MP_OBJ_FROM_PTR(&uumpy_type_ndarray))) {
+        uumpy_obj_ndarray_t *x = MP_OBJ_TO_PTR(x_in);
+        if (x->typecode == UUMPY_DEFAULT_TYPE) {
+            return x;
+        }
+    }
+    return uumpy_array_from_value(x_in, UUMPY_DEFAULT_TYPE);
+}
+
+// Get a 1-D array of row or column indices
+static uumpy_obj_ndarray_t *_sparse_index_array(mp_obj_t x_in) {
+    uumpy_obj_ndarray_t *x = uumpy_array_from_value(x_in, 'i');
+
+    if (x->dim_count != 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("indices must be 1-D"));
+    }
+
+    return x;
+}
+
+static uumpy_sparse_obj_csr_t *_sparse_csr_new(mp_int_t rows, mp_int_t cols, mp_int_t nnz) {
+    uumpy_sparse_obj_csr_t *o = uumpy_new_obj(uumpy_sparse_obj_csr_t);
+    o->base.type = &uumpy_sparse_type_csr_matrix;
+    o->rows = rows;
+    o->cols = cols;
+    o->nnz = nnz;
+    o->indptr = uumpy_new(mp_int_t, rows + 1);
+    o->indices = uumpy_new(mp_int_t, nnz);
+    o->data = uumpy_new(mp_float_t, nnz);
+
+    return o;
+}
+
+// Build from coordinate (COO) triplets. The entries are bucketed by row
+// with a counting sort, each row is then sorted by column and any
+// duplicate entries are summed, as they are in scipy.
+static void _sparse_csr_from_triplets(uumpy_sparse_obj_csr_t *o, mp_obj_t data_in,
+                                      mp_obj_t row_in, mp_obj_t col_in, bool have_shape) {
+    uumpy_obj_ndarray_t *values = _sparse_float_array(data_in);
+    uumpy_obj_ndarray_t *row_array = _sparse_index_array(row_in);
+    uumpy_obj_ndarray_t *col_array = _sparse_index_array(col_in);
+
+    if (values->dim_count != 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("data must be 1-D"));
+    }
+
+    mp_int_t count = values->dim_info[0].length;
+    if (row_array->dim_info[0].length != count || col_array->dim_info[0].length != count) {
+        mp_raise_ValueError(MP_ERROR_TEXT("data, row and col must be the same length"));
+    }
+
+    // The index arrays are fresh copies so they are contiguous
+    int *row = (int *) row_array->data;
+    int *col = (int *) col_array->data;
+    mp_float_t *values_data = ((mp_float_t *) values->data) + values->base_offset;
+    mp_int_t values_stride = values->dim_info[0].stride;
+
+    if (!have_shape) {
+        o->rows = 0;
+        o->cols = 0;
+        for (mp_int_t k=0; k < count; k++) {
+            o->rows = MAX(o->rows, row[k] + 1);
+            o->cols = MAX(o->cols, col[k] + 1);
+        }
+    }
+
+    mp_int_t *indptr = uumpy_new(mp_int_t, o->rows + 1);
+    memset(indptr, 0, (o->rows + 1) * sizeof(mp_int_t));
+
+    for (mp_int_t k=0; k < count; k++) {
+        if (row[k] < 0 || row[k] >= o->rows || col[k] < 0 || col[k] >= o->cols) {
+            mp_raise_ValueError(MP_ERROR_TEXT("index out of range"));
+        }
+        indptr[row[k] + 1]++;
+    }
+    for (mp_int_t i=0; i < o->rows; i++) {
+        indptr[i + 1] += indptr[i];
+    }
+
+    mp_int_t *indices = uumpy_new(mp_int_t, count);
+    mp_float_t *data = uumpy_new(mp_float_t, count);
+    mp_int_t *next = uumpy_new(mp_int_t, o->rows);
+    memcpy(next, indptr, o->rows * sizeof(mp_int_t));
+
+    for (mp_int_t k=0; k < count; k++) {
+        mp_int_t dest = next[row[k]]++;
+        indices[dest] = col[k];
+        data[dest] = values_data[k * values_stride];
+    }
+    m_del(mp_int_t, next, o->rows);
+
+    // Rows are usually short so an insertion sort is fine. The start of
+    // each row moves down as duplicates are merged, but the end of the
+    // current row is read before it is overwritten.
+    mp_int_t used = 0;
+    mp_int_t start = 0;
+    for (mp_int_t i=0; i < o->rows; i++) {
+        mp_int_t end = indptr[i + 1];
+
+        for (mp_int_t k=start + 1; k < end; k++) {
+            mp_int_t c = indices[k];
+            mp_float_t v = data[k];
+            mp_int_t j = k;
+            while (j > start && indices[j - 1] > c) {
+                indices[j] = indices[j - 1];
+                data[j] = data[j - 1];
+                j--;
+            }
+            indices[j] = c;
+            data[j] = v;
+        }
+
+        indptr[i] = used;
+        for (mp_int_t k=start; k < end; k++) {
+            if (used > indptr[i] && indices[used - 1] == indices[k]) {
+                data[used - 1] += data[k];
+            } else {
+                indices[used] = indices[k];
+                data[used] = data[k];
+                used++;
+            }
+        }
+        start = end;
+    }
+    indptr[o->rows] = used;
+
+    if (used < count) {
+        indices = uumpy_renew(mp_int_t, indices, count, used);
+        data = uumpy_renew(mp_float_t, data, count, used);
+    }
+
+    o->nnz = used;
+    o->indptr = indptr;
+    o->indices = indices;
+    o->data = data;
+}
+
+// Build from a dense 2-D array, keeping only the non-zero values
+static void _sparse_csr_from_dense(uumpy_sparse_obj_csr_t *o, mp_obj_t dense_in) {
+    uumpy_obj_ndarray_t *a = _sparse_float_array(dense_in);
+
+    if (a->dim_count != 2) {
+        mp_raise_ValueError(MP_ERROR_TEXT("expected a 2-D array"));
+    }
+
+    mp_float_t *a_data = ((mp_float_t *) a->data) + a->base_offset;
+    mp_int_t row_stride = a->dim_info[0].stride;
+    mp_int_t col_stride = a->dim_info[1].stride;
+    mp_int_t nnz = 0;
+
+    o->rows = a->dim_info[0].length;
+    o->cols = a->dim_info[1].length;
+
+    for (mp_int_t i=0; i < o->rows; i++) {
+        for (mp_int_t j=0; j < o->cols; j++) {
+            if (a_data[i * row_stride + j * col_stride] != 0) {
+                nnz++;
+            }
+        }
+    }
+
+    o->nnz = nnz;
+    o->indptr = uumpy_new(mp_int_t, o->rows + 1);
+    o->indices = uumpy_new(mp_int_t, nnz);
+    o->data = uumpy_new(mp_float_t, nnz);
+
+    nnz = 0;
+    for (mp_int_t i=0; i < o->rows; i++) {
+        o->indptr[i] = nnz;
+        for (mp_int_t j=0; j < o->cols; j++) {
+            mp_float_t v = a_data[i * row_stride + j * col_stride];
+            if (v != 0) {
+                o->indices[nnz] = j;
+                o->data[nnz] = v;
+                nnz++;
+            }
+        }
+    }
+    o->indptr[o->rows] = nnz;
+}
+
+// csr_matrix(dense) or csr_matrix((data, (row, col)), shape=(m, n))
+static mp_obj_t uumpy_sparse_csr_make_new(const mp_obj_type_t *type_in, size_t n_args,
+                                          size_t n_kw, const mp_obj_t *all_args) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_arg1,
+        ARG_shape,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_arg1,  MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_shape, MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, all_args + n_args);
+    mp_arg_parse_all(n_args, all_args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_sparse_obj_csr_t *o = uumpy_new_obj(uumpy_sparse_obj_csr_t);
+    o->base.type = type_in;
+
+    bool have_shape = (args[ARG_shape].u_obj != mp_const_none);
+    if (have_shape) {
+        mp_obj_t *shape;
+        mp_obj_get_array_fixed_n(args[ARG_shape].u_obj, 2, &shape);
+        o->rows = mp_obj_get_int(shape[0]);
+        o->cols = mp_obj_get_int(shape[1]);
+        if (o->rows < 0 || o->cols < 0) {
+            mp_raise_ValueError(MP_ERROR_TEXT("negative dimensions are not allowed"));
+        }
+    }
+
+    mp_obj_t arg1 = args[ARG_arg1].u_obj;
+    size_t len;
+    mp_obj_t *items;
+
+    if (mp_obj_is_type(arg1, &mp_type_tuple)) {
+        mp_obj_tuple_get(arg1, &len, &items);
+        if (len == 2 && mp_obj_is_type(items[1], &mp_type_tuple)) {
+            mp_obj_t *coords;
+            mp_obj_get_array_fixed_n(items[1], 2, &coords);
+            _sparse_csr_from_triplets(o, items[0], coords[0], coords[1], have_shape);
+            return MP_OBJ_FROM_PTR(o);
+        }
+    }
+
+    mp_int_t rows = o->rows;
+    mp_int_t cols = o->cols;
+    _sparse_csr_from_dense(o, arg1);
+    if (have_shape && (rows != o->rows || cols != o->cols)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("shape does not match the array"));
+    }
+
+    return MP_OBJ_FROM_PTR(o);
+}
+
+static void uumpy_sparse_csr_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    uumpy_sparse_obj_csr_t *self = MP_OBJ_TO_PTR(self_in);
+
+    mp_printf(print, "<%dx%d sparse matrix with %d stored elements>",
+              (int) self->rows, (int) self->cols, (int) self->nnz);
+}
+
+// Y = A X, or Y = A^T X when transposed, for p columns of X at once. The
+// dense operands are given as pointers to their first element along with
+// their row and column strides, so views can be used directly.
+void uumpy_sparse_csr_multiply(uumpy_sparse_obj_csr_t *a, bool transpose, mp_int_t p,
+                               const mp_float_t *x, mp_int_t x_rs, mp_int_t x_cs,
+                               mp_float_t *y, mp_int_t y_rs, mp_int_t y_cs) {
+    const mp_int_t *indptr = a->indptr;
+    const mp_int_t *indices = a->indices;
+    const mp_float_t *data = a->data;
+
+    if (!transpose) {
+        if (p == 1) {
+            for (mp_int_t i=0; i < a->rows; i++) {
+                mp_float_t acc = 0;
+                for (mp_int_t k=indptr[i]; k < indptr[i + 1]; k++) {
+                    acc += data[k] * x[indices[k] * x_rs];
+                }
+                y[i * y_rs] = acc;
+            }
+            return;
+        }
+
+        for (mp_int_t i=0; i < a->rows; i++) {
+            mp_float_t *y_row = y + i * y_rs;
+            for (mp_int_t c=0; c < p; c++) {
+                y_row[c * y_cs] = 0;
+            }
+            for (mp_int_t k=indptr[i]; k < indptr[i + 1]; k++) {
+                const mp_float_t *x_row = x + indices[k] * x_rs;
+                mp_float_t v = data[k];
+                for (mp_int_t c=0; c < p; c++) {
+                    y_row[c * y_cs] += v * x_row[c * x_cs];
+                }
+            }
+        }
+    } else {
+        // Scatter each row of A, scaled by the matching row of X, into the
+        // rows of Y picked out by its column indices
+        for (mp_int_t j=0; j < a->cols; j++) {
+            for (mp_int_t c=0; c < p; c++) {
+                y[j * y_rs + c * y_cs] = 0;
+            }
+        }
+
+        for (mp_int_t i=0; i < a->rows; i++) {
+            const mp_float_t *x_row = x + i * x_rs;
+            for (mp_int_t k=indptr[i]; k < indptr[i + 1]; k++) {
+                mp_float_t *y_row = y + indices[k] * y_rs;
+                mp_float_t v = data[k];
+                for (mp_int_t c=0; c < p; c++) {
+                    y_row[c * y_cs] += v * x_row[c * x_cs];
+                }
+            }
+        }
+    }
+}
+
+static uumpy_obj_ndarray_t *_sparse_multiply_impl(uumpy_sparse_obj_csr_t *self, mp_obj_t x_in,
+                                                  mp_obj_t out_in, bool transpose) {
+    uumpy_obj_ndarray_t *x = _sparse_float_array(x_in);
+    mp_int_t inner = transpose ? self->rows : self->cols;
+    mp_int_t dims[2] = {transpose ? self->cols : self->rows, 1};
+
+    if (x->dim_count < 1 || x->dim_count > 2) {
+        mp_raise_ValueError(MP_ERROR_TEXT("operand must be 1-D or 2-D"));
+    }
+    if (x->dim_info[0].length != inner) {
+        mp_raise_ValueError(MP_ERROR_TEXT("dimension mismatch"));
+    }
+
+    bool is_matrix = (x->dim_count == 2);
+    if (is_matrix) {
+        dims[1] = x->dim_info[1].length;
+    }
+
+    uumpy_obj_ndarray_t *out;
+
+    if (out_in == mp_const_none) {
+        out = ndarray_new(UUMPY_DEFAULT_TYPE, x->dim_count, dims);
+    } else {
+        out = MP_OBJ_TO_PTR(out_in);
+        if (!mp_obj_is_type(out_in, MP_OBJ_FROM_PTR(&uumpy_type_ndarray)) ||
+            out->typecode != UUMPY_DEFAULT_TYPE) {
+            mp_raise_TypeError(MP_ERROR_TEXT("out must be a float array"));
+        }
+        if (out->dim_count != x->dim_count || out->dim_info[0].length != dims[0] ||
+            (is_matrix && out->dim_info[1].length != dims[1])) {
+            mp_raise_ValueError(MP_ERROR_TEXT("out has the wrong shape"));
+        }
+        // The result is built up in place, so it can't share memory with x
+        if (ufunc_may_overlap(out, x)) {
+            mp_raise_ValueError(MP_ERROR_TEXT("out must not overlap the operand"));
+        }
+    }
+
+    uumpy_sparse_csr_multiply(self, transpose, dims[1],
+                              ((mp_float_t *) x->data) + x->base_offset,
+                              x->dim_info[0].stride, is_matrix ? x->dim_info[1].stride : 0,
+                              ((mp_float_t *) out->data) + out->base_offset,
+                              out->dim_info[0].stride, is_matrix ? out->dim_info[1].stride : 0);
+
+    return out;
+}
+
+static mp_obj_t _sparse_multiply_method(size_t n_args, const mp_obj_t *pos_args,
+                                        mp_map_t *kw_args, bool transpose) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    enum {
+        ARG_self,
+        ARG_x,
+        ARG_out,
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_self, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_x,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_out,  MP_ARG_KW_ONLY  | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uumpy_sparse_obj_csr_t *self = MP_OBJ_TO_PTR(args[ARG_self].u_obj);
+
+    return MP_OBJ_FROM_PTR(_sparse_multiply_impl(self, args[ARG_x].u_obj, args[ARG_out].u_obj, transpose));
+}
+
+// A.dot(x, *, out=None) computes A x for a vector or a dense matrix x
+static mp_obj_t uumpy_sparse_csr_dot(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    return _sparse_multiply_method(n_args, pos_args, kw_args, false);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_sparse_csr_dot_obj, 2, uumpy_sparse_csr_dot);
+
+// A.tdot(x, *, out=None) computes A^T x without forming the transpose
+static mp_obj_t uumpy_sparse_csr_tdot(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    return _sparse_multiply_method(n_args, pos_args, kw_args, true);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(uumpy_sparse_csr_tdot_obj, 2, uumpy_sparse_csr_tdot);
+
+static mp_obj_t uumpy_sparse_csr_todense(mp_obj_t self_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_sparse_obj_csr_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_int_t dims[2] = {self->rows, self->cols};
+    uumpy_obj_ndarray_t *dense = ndarray_new(UUMPY_DEFAULT_TYPE, 2, dims);
+    mp_float_t *dense_data = (mp_float_t *) dense->data;
+
+    memset(dense_data, 0, self->rows * self->cols * sizeof(mp_float_t));
+    for (mp_int_t i=0; i < self->rows; i++) {
+        for (mp_int_t k=self->indptr[i]; k < self->indptr[i + 1]; k++) {
+            dense_data[i * self->cols + self->indices[k]] = self->data[k];
+        }
+    }
+
+    return MP_OBJ_FROM_PTR(dense);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_sparse_csr_todense_obj, uumpy_sparse_csr_todense);
+
+// The transpose in CSR form is the original in compressed column form, so
+// it is another counting sort, this time by column. Visiting the rows in
+// order leaves the new column indices sorted.
+static mp_obj_t uumpy_sparse_csr_transpose(mp_obj_t self_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_sparse_obj_csr_t *self = MP_OBJ_TO_PTR(self_in);
+    uumpy_sparse_obj_csr_t *t = _sparse_csr_new(self->cols, self->rows, self->nnz);
+
+    memset(t->indptr, 0, (t->rows + 1) * sizeof(mp_int_t));
+    for (mp_int_t k=0; k < self->nnz; k++) {
+        t->indptr[self->indices[k] + 1]++;
+    }
+    for (mp_int_t j=0; j < t->rows; j++) {
+        t->indptr[j + 1] += t->indptr[j];
+    }
+
+    mp_int_t *next = uumpy_new(mp_int_t, t->rows);
+    memcpy(next, t->indptr, t->rows * sizeof(mp_int_t));
+
+    for (mp_int_t i=0; i < self->rows; i++) {
+        for (mp_int_t k=self->indptr[i]; k < self->indptr[i + 1]; k++) {
+            mp_int_t dest = next[self->indices[k]]++;
+            t->indices[dest] = i;
+            t->data[dest] = self->data[k];
+        }
+    }
+    m_del(mp_int_t, next, t->rows);
+
+    return MP_OBJ_FROM_PTR(t);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(uumpy_sparse_csr_transpose_obj, uumpy_sparse_csr_transpose);
+
+// Return a view of a 2-D array with its axes swapped
+static uumpy_obj_ndarray_t *_sparse_swap_axes(uumpy_obj_ndarray_t *a) {
+    uumpy_dim_info dim_info[2] = {a->dim_info[1], a->dim_info[0]};
+
+    return ndarray_new_view(a, a->base_offset, 2, dim_info);
+}
+
+static mp_obj_t uumpy_sparse_csr_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t rhs_in) {
+    UUMPY_GRAPH_UNRECORDABLE();
+
+    uumpy_sparse_obj_csr_t *self = MP_OBJ_TO_PTR(lhs_in);
+
+    switch (op) {
+    case MP_BINARY_OP_MAT_MULTIPLY:
+        return MP_OBJ_FROM_PTR(_sparse_multiply_impl(self, rhs_in, mp_const_none, false));
+
+    case MP_BINARY_OP_REVERSE_MAT_MULTIPLY: {
+        // x @ A is (A^T x^T)^T
+        uumpy_obj_ndarray_t *x = _sparse_float_array(rhs_in);
+        if (x->dim_count != 2) {
+            return MP_OBJ_FROM_PTR(_sparse_multiply_impl(self, MP_OBJ_FROM_PTR(x), mp_const_none, true));
+        }
+        uumpy_obj_ndarray_t *y = _sparse_multiply_impl(self, MP_OBJ_FROM_PTR(_sparse_swap_axes(x)),
+                                                       mp_const_none, true);
+        return MP_OBJ_FROM_PTR(_sparse_swap_axes(y));
+    }
+
+    default:
+        return MP_OBJ_NULL;
+    }
+}
+
+static void uumpy_sparse_csr_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
+    if (dest[0] != MP_OBJ_NULL) {
+        // not load attribute
+        return;
+    }
+    uumpy_sparse_obj_csr_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if (attr == MP_QSTR_shape) {
+        mp_obj_t shape[2] = {MP_OBJ_NEW_SMALL_INT(self->rows), MP_OBJ_NEW_SMALL_INT(self->cols)};
+        dest[0] = mp_obj_new_tuple(2, shape);
+    } else if (attr == MP_QSTR_nnz) {
+        dest[0] = MP_OBJ_NEW_SMALL_INT(self->nnz);
+    } else if (attr == MP_QSTR_T) {
+        dest[0] = uumpy_sparse_csr_transpose(self_in);
+    } else {
+        // Continue the lookup in the locals dict
+        dest[1] = MP_OBJ_SENTINEL;
+    }
+}
+
+static const mp_rom_map_elem_t uumpy_sparse_csr_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_dot), MP_ROM_PTR(&uumpy_sparse_csr_dot_obj) },
+    { MP_ROM_QSTR(MP_QSTR_tdot), MP_ROM_PTR(&uumpy_sparse_csr_tdot_obj) },
+    { MP_ROM_QSTR(MP_QSTR_todense), MP_ROM_PTR(&uumpy_sparse_csr_todense_obj) },
+    { MP_ROM_QSTR(MP_QSTR_transpose), MP_ROM_PTR(&uumpy_sparse_csr_transpose_obj) },
+};
+static MP_DEFINE_CONST_DICT(uumpy_sparse_csr_locals_dict, uumpy_sparse_csr_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    uumpy_sparse_type_csr_matrix,
+    MP_QSTR_csr_matrix,
+    MP_TYPE_FLAG_NONE,
+    make_new, uumpy_sparse_csr_make_new,
+    print, uumpy_sparse_csr_print,
+    binary_op, uumpy_sparse_csr_binary_op,
+    attr, uumpy_sparse_csr_attr,
+    locals_dict, &uumpy_sparse_csr_locals_dict
+);
+
+static const mp_rom_map_elem_t uumpy_sparse_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_csr_matrix), MP_ROM_PTR(&uumpy_sparse_type_csr_matrix) },
+    // The iterative solvers accept sparse matrices directly
+    { MP_ROM_QSTR(MP_QSTR_cg), MP_ROM_PTR(&uumpy_linalg_cg_obj) },
+    { MP_ROM_QSTR(MP_QSTR_gmres), MP_ROM_PTR(&uumpy_linalg_gmres_obj) },
+};
+static MP_DEFINE_CONST_DICT(uumpy_sparse_module_globals, uumpy_sparse_module_globals_table);
+
+// Define module object.
+const mp_obj_module_t uumpy_sparse_module = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&uumpy_sparse_module_globals,
+};
+
+#endif // UUMPY_ENABLE_SPARSE
@@ -0,0 +1,56 @@
+/*
+ * This file is part of the uumpy project
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Nicko van Someren
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// SPDX-License-Identifier: MIT
+
+#ifndef UUMPY_INCLUDED_UUSPARSE_H
+#define UUMPY_INCLUDED_UUSPARSE_H
+
+#if UUMPY_ENABLE_SPARSE
+
+// A sparse matrix in compressed sparse row form. The values and column
+// indices of row i are held in data[indptr[i]] to data[indptr[i+1]-1],
+// with the columns in increasing order within each row.
+typedef struct _uumpy_sparse_obj_csr_t {
+    mp_obj_base_t base;
+    mp_int_t rows;
+    mp_int_t cols;
+    mp_int_t nnz;
+    mp_int_t *indptr;
+    mp_int_t *indices;
+    mp_float_t *data;
+} uumpy_sparse_obj_csr_t;
+
+extern const mp_obj_type_t uumpy_sparse_type_csr_matrix;
+
+void uumpy_sparse_csr_multiply(uumpy_sparse_obj_csr_t *a, bool transpose, mp_int_t p,
+                               const mp_float_t *x, mp_int_t x_rs, mp_int_t x_cs,
+                               mp_float_t *y, mp_int_t y_rs, mp_int_t y_cs);
+extern const mp_obj_module_t uumpy_sparse_module;
+
+#endif // UUMPY_ENABLE_SPARSE
+
+#endif // UUMPY_INCLUDED_UUSPARSE_H